@@ -0,0 +1,110 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace ph {
+
+// Sample rate that voices per core are counted at
+constexpr float BENCH_SAMPLE_RATE = 48000.f;
+
+// Times benchmark cases and prints one JSON object per line to stdout, so runs can be diffed and tracked between
+// releases. Audio cases report ns_per_sample, the cost of one frame of every channel, and voices_per_core, how many
+// voices one core could render in real time at BENCH_SAMPLE_RATE. Other cases report ns_per_op.
+class Bench {
+public:
+    // Only cases whose "group/name" contains filter are run
+    explicit Bench(const std::string& filter) : filter(filter) {}
+
+    // fn renders `frames` frames of `channels` voices and returns a sample, so the work isn't optimised away
+    template <typename F>
+    void runAudio(const std::string& group, const std::string& name, int channels, int frames, F fn) {
+        if (!selected(group, name)) {
+            return;
+        }
+
+        double nsPerSample = time(fn) / frames;
+        double voicesPerCore = channels * 1e9 / (nsPerSample * BENCH_SAMPLE_RATE);
+        std::printf("{\"group\": \"%s\", \"name\": \"%s\", \"channels\": %d, \"ns_per_sample\": %.3f, "
+                    "\"voices_per_core\": %.1f}\n",
+                    group.c_str(), name.c_str(), channels, nsPerSample, voicesPerCore);
+        std::fflush(stdout);
+    }
+
+    // fn does `ops` operations and returns a value depending on them
+    template <typename F>
+    void runOps(const std::string& group, const std::string& name, int ops, F fn) {
+        if (!selected(group, name)) {
+            return;
+        }
+
+        double nsPerOp = time(fn) / ops;
+        std::printf("{\"group\": \"%s\", \"name\": \"%s\", \"ns_per_op\": %.3f}\n", group.c_str(), name.c_str(),
+                    nsPerOp);
+        std::fflush(stdout);
+    }
+
+    // Keeps results alive so the compiler can't drop the work that made them
+    volatile float sink = 0.f;
+
+    // Makes the compiler assume any memory may have changed, so a case can't hoist work on its inputs out of the
+    // timing loop
+    static void clobberMemory() { asm volatile("" : : : "memory"); }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    // Runs at least this long in each round
+    static constexpr double ROUND_SECONDS = 0.02;
+    static constexpr int ROUNDS = 5;
+
+    bool selected(const std::string& group, const std::string& name) const {
+        return (group + "/" + name).find(filter) != std::string::npos;
+    }
+
+    // Median ns per call of fn over ROUNDS rounds, after finding how many calls fill a round
+    template <typename F>
+    double time(F& fn) {
+        sink = sink + fn();
+
+        long calls = 1;
+        for (;;) {
+            double seconds = runCalls(fn, calls);
+            if (seconds >= ROUND_SECONDS) {
+                break;
+            }
+            calls *= 2;
+        }
+
+        std::vector<double> rounds;
+        for (int i = 0; i < ROUNDS; ++i) {
+            rounds.push_back(runCalls(fn, calls) * 1e9 / calls);
+        }
+        std::sort(rounds.begin(), rounds.end());
+        return rounds[ROUNDS / 2];
+    }
+
+    template <typename F>
+    double runCalls(F& fn, long calls) {
+        float sum = 0.f;
+        Clock::time_point start = Clock::now();
+        for (long i = 0; i < calls; ++i) {
+            sum += fn();
+        }
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+        sink = sink + sum;
+        return elapsed.count();
+    }
+
+    std::string filter;
+};
+
+void benchSineBackend(Bench& bench);
+void benchSignalGenerator(Bench& bench);
+void benchDirectedGraph(Bench& bench);
+void benchSpiderEngine(Bench& bench);
+
+} // namespace ph
@@ -0,0 +1,111 @@
+#include "AlgorithmLibrary.hpp"
+#include "Bench.hpp"
+#include "DirectedGraph.hpp"
+#include "FixedDirectedGraph.hpp"
+#include "RoutingSchedule.hpp"
+#include "ScheduleCache.hpp"
+
+namespace ph {
+
+namespace {
+
+// Every edge of a 6 vertex graph, lower vertices first, which is the order the UI adds a dense algorithm in
+std::vector<std::pair<int, int>> allEdges() {
+    std::vector<std::pair<int, int>> edges;
+    for (int src = 0; src < 6; ++src) {
+        for (int dest = 0; dest < 6; ++dest) {
+            if (src != dest) {
+                edges.push_back({src, dest});
+            }
+        }
+    }
+    return edges;
+}
+
+} // anonymous namespace
+
+void benchDirectedGraph(Bench& bench) {
+    const std::vector<std::pair<int, int>> edges = allEdges();
+    const int edgeCount = edges.size();
+
+    // Each pass toggles every edge on and back off, so the graph ends where it started
+    bench.runOps("graph", "DirectedGraph toggleEdge", 2 * edgeCount, [&] {
+        DirectedGraph<int> graph(6);
+        int added = 0;
+        for (const auto& edge : edges) {
+            added += graph.toggleEdge(edge.first, edge.second) == ToggleEdgeResult::ADDED;
+        }
+        for (const auto& edge : edges) {
+            graph.toggleEdge(edge.first, edge.second);
+        }
+        return float(added);
+    });
+
+    bench.runOps("graph", "FixedDirectedGraph toggleEdge", 2 * edgeCount, [&] {
+        FixedDirectedGraph<6> graph;
+        int added = 0;
+        for (const auto& edge : edges) {
+            added += graph.toggleEdge(edge.first, edge.second);
+        }
+        for (const auto& edge : edges) {
+            graph.toggleEdge(edge.first, edge.second);
+        }
+        return float(added);
+    });
+
+    // The densest acyclic graph, every vertex modulating all those below it
+    DirectedGraph<int> listGraph(6);
+    FixedDirectedGraph<6> fixedGraph;
+    for (int src = 1; src < 6; ++src) {
+        for (int dest = 0; dest < src; ++dest) {
+            listGraph.addEdge(src, dest);
+            fixedGraph.addEdge(src, dest);
+        }
+    }
+
+    bench.runOps("graph", "DirectedGraph topologicalSort, dense", 1, [&] {
+        return float(listGraph.topologicalSort()[0]);
+    });
+
+    std::array<int, 6> order;
+    bench.runOps("graph", "FixedDirectedGraph topologicalSort, dense", 1, [&] {
+        fixedGraph.topologicalSort(order);
+        return float(order[0]);
+    });
+
+    std::array<bool, 6> carriers = {true, false, false, false, false, false};
+    bench.runOps("graph", "Sort and compile schedule, dense", 1, [&] {
+        RoutingSchedule<6> schedule;
+        fixedGraph.topologicalSort(order);
+        schedule.compile(fixedGraph, order);
+        schedule.setCarriers(carriers);
+        return float(schedule.order[0]);
+    });
+
+    // As many library algorithms as the cache holds, looked up in turn so every lookup builds a different key and
+    // searches the cache again
+    const int routingCount = 8;
+    std::vector<FixedDirectedGraph<6>> graphs(routingCount);
+    std::vector<std::array<bool, 6>> routingCarriers(routingCount);
+    ScheduleCache<6, routingCount> cache;
+    for (int i = 0; i < routingCount; ++i) {
+        loadLibraryAlgorithm(i, graphs[i], routingCarriers[i]);
+        graphs[i].topologicalSort(order);
+
+        RoutingSchedule<6> schedule;
+        schedule.compile(graphs[i], order);
+        schedule.setCarriers(routingCarriers[i]);
+        cache.insert(ScheduleCache<6>::key(graphs[i], routingCarriers[i]), schedule);
+    }
+
+    bench.runOps("graph", "Schedule cache lookup", routingCount, [&] {
+        Bench::clobberMemory();
+        int sum = 0;
+        for (int i = 0; i < routingCount; ++i) {
+            sum += cache.find(ScheduleCache<6>::key(graphs[i], routingCarriers[i]))->order[0];
+        }
+        return float(sum);
+    });
+}
+
+} // namespace ph
@@ -0,0 +1,71 @@
+#include "Bench.hpp"
+#include "SignalGenerator.hpp"
+
+namespace ph {
+
+namespace {
+
+const int FRAMES = 1024;
+const float SAMPLE_TIME = 1.f / BENCH_SAMPLE_RATE;
+
+// The middle of each segment of the morph, and pure sine
+const struct {
+    const char* name;
+    float wavePos;
+} SEGMENTS[] = {
+    {"sine", 0.f},
+    {"sine-triangle", 0.125f},
+    {"triangle-saw", 0.375f},
+    {"saw-square", 0.625f},
+    {"square-sine", 0.875f},
+};
+
+} // anonymous namespace
+
+void benchSignalGenerator(Bench& bench) {
+    for (const auto& segment : SEGMENTS) {
+        float wavePos = segment.wavePos;
+        std::string name = segment.name;
+
+        bench.runAudio("generate", name + ", scalar", 1, FRAMES, [&] {
+            SpiderSignalGenerator gen;
+            float sum = 0.f;
+            for (int i = 0; i < FRAMES; ++i) {
+                sum += gen.generate(SAMPLE_TIME, 440.f, wavePos, 0.5f);
+            }
+            return sum;
+        });
+
+        bench.runAudio("generate", name + ", SIMD", 4, FRAMES, [&] {
+            TSpiderSignalGenerator<simd::float_4> gen;
+            simd::float_4 freq(220.f, 330.f, 440.f, 550.f);
+            simd::float_4 sum = 0.f;
+            for (int i = 0; i < FRAMES; ++i) {
+                sum += gen.generate(SAMPLE_TIME, freq, wavePos, 0.5f);
+            }
+            return sum[0] + sum[1] + sum[2] + sum[3];
+        });
+
+        bench.runAudio("generate", name + ", fixed phase SIMD", 4, FRAMES, [&] {
+            TFixedPhaseSignalGenerator<simd::float_4> gen;
+            simd::float_4 freq(220.f, 330.f, 440.f, 550.f);
+            simd::float_4 sum = 0.f;
+            for (int i = 0; i < FRAMES; ++i) {
+                sum += gen.generate(SAMPLE_TIME, freq, wavePos, 0.5f);
+            }
+            return sum[0] + sum[1] + sum[2] + sum[3];
+        });
+
+        bench.runAudio("generate", name + ", band-limited SIMD", 4, FRAMES, [&] {
+            TFixedPhaseSignalGenerator<simd::float_4> gen;
+            simd::float_4 freq(220.f, 330.f, 440.f, 550.f);
+            simd::float_4 sum = 0.f;
+            for (int i = 0; i < FRAMES; ++i) {
+                sum += gen.generateBandLimited(SAMPLE_TIME, freq, wavePos, 0.5f);
+            }
+            return sum[0] + sum[1] + sum[2] + sum[3];
+        });
+    }
+}
+
+} // namespace ph
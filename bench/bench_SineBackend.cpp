@@ -0,0 +1,45 @@
+#include "Bench.hpp"
+#include "SineBackend.hpp"
+
+namespace ph {
+
+namespace {
+
+const int PHASE_COUNT = 4096;
+
+template <typename Sine>
+void benchBackend(Bench& bench, const std::string& name, const std::vector<float>& phases) {
+    bench.runAudio("sin2pi", name + ", scalar", 1, PHASE_COUNT, [&] {
+        float sum = 0.f;
+        for (float phase : phases) {
+            sum += Sine::sin2pi(phase);
+        }
+        return sum;
+    });
+
+    bench.runAudio("sin2pi", name + ", SIMD", 4, PHASE_COUNT / 4, [&] {
+        simd::float_4 sum = 0.f;
+        for (int i = 0; i < PHASE_COUNT; i += 4) {
+            sum += Sine::sin2pi(simd::float_4::load(&phases[i]));
+        }
+        return sum[0] + sum[1] + sum[2] + sum[3];
+    });
+}
+
+} // anonymous namespace
+
+void benchSineBackend(Bench& bench) {
+    // Phases past one cycle so every backend's wrapping is included
+    std::vector<float> phases(PHASE_COUNT);
+    for (int i = 0; i < PHASE_COUNT; ++i) {
+        phases[i] = 3.f * i / PHASE_COUNT - 1.f;
+    }
+
+    benchBackend<LinearSineTable<256>>(bench, "Linear 256", phases);
+    benchBackend<LinearSineTable<4096>>(bench, "Linear 4096", phases);
+    benchBackend<CubicSineTable<256>>(bench, "Cubic 256", phases);
+    benchBackend<CubicSineTable<1024>>(bench, "Cubic 1024", phases);
+    benchBackend<MinimaxSine>(bench, "Minimax", phases);
+}
+
+} // namespace ph
@@ -0,0 +1,112 @@
+#include "AlgorithmLibrary.hpp"
+#include "Bench.hpp"
+#include "FixedDirectedGraph.hpp"
+#include "SpiderEngine.hpp"
+
+namespace ph {
+
+namespace {
+
+const int CHANNEL_COUNTS[] = {1, 2, 4, 8, 16};
+
+// Spider::process() renders one frame at a time, Rack's block processing would render many
+const int BLOCK_SIZES[] = {1, 256};
+
+struct Patch {
+    const char* name;
+    FixedDirectedGraph<OPERATOR_COUNT> graph;
+    std::array<bool, OPERATOR_COUNT> carriers;
+    // Marks the schedule to render on this library algorithm's kernel, see SpiderEngine::processLibraryFrame()
+    int libraryAlgorithm = -1;
+};
+
+std::vector<Patch> patches() {
+    std::vector<Patch> patches(7);
+
+    // A 2-op stack, the other four operators can't reach the output
+    patches[0].name = "sparse";
+    patches[0].graph.addEdge(1, 0);
+    patches[0].carriers = {true, false, false, false, false, false};
+
+    // Every operator modulates all those below it
+    patches[1].name = "dense";
+    for (int src = 1; src < OPERATOR_COUNT; ++src) {
+        for (int dest = 0; dest < src; ++dest) {
+            patches[1].graph.addEdge(src, dest);
+        }
+    }
+    patches[1].carriers = {true, false, false, false, false, false};
+
+    patches[2].name = "all carriers";
+    loadLibraryAlgorithm(31, patches[2].graph, patches[2].carriers);
+
+    patches[3].name = "algorithm 5";
+    loadLibraryAlgorithm(4, patches[3].graph, patches[3].carriers);
+
+    // Operators 2 and 3 modulate each other
+    patches[4].name = "feedback loop";
+    patches[4].graph.addEdge(1, 0);
+    patches[4].graph.addEdge(2, 1);
+    patches[4].graph.addEdge(1, 2);
+    patches[4].carriers = {true, false, false, false, false, false};
+
+    // The same two library algorithms on their own kernels rather than the generic processFrame()
+    patches[5].name = "all carriers, library kernel";
+    loadLibraryAlgorithm(31, patches[5].graph, patches[5].carriers);
+    patches[5].libraryAlgorithm = 31;
+
+    patches[6].name = "algorithm 5, library kernel";
+    loadLibraryAlgorithm(4, patches[6].graph, patches[6].carriers);
+    patches[6].libraryAlgorithm = 4;
+
+    return patches;
+}
+
+} // anonymous namespace
+
+void benchSpiderEngine(Bench& bench) {
+    SpiderParams params = {};
+    for (int op = 0; op < OPERATOR_COUNT; ++op) {
+        params.operators[op].level = 0.8f;
+        params.operators[op].wave = 0.2f * op;
+        params.operators[op].pitch = op;
+        params.operators[op].feedback = 0.1f;
+    }
+
+    RenderArgs args;
+    args.sampleRate = BENCH_SAMPLE_RATE;
+    args.sampleTime = 1.f / BENCH_SAMPLE_RATE;
+
+    for (const Patch& patch : patches()) {
+        RoutingSchedule<OPERATOR_COUNT> schedule;
+        std::array<int, OPERATOR_COUNT> order;
+        patch.graph.topologicalSort(order);
+        schedule.compile(patch.graph, order);
+        schedule.setCarriers(patch.carriers);
+        schedule.libraryAlgorithm = patch.libraryAlgorithm;
+
+        for (int channels : CHANNEL_COUNTS) {
+            for (int frames : BLOCK_SIZES) {
+                SpiderEngine engine;
+                engine.setSchedule(schedule);
+                engine.channels = channels;
+
+                std::vector<float> pitch(frames * MAX_CHANNEL_COUNT);
+                for (int frame = 0; frame < frames; ++frame) {
+                    for (int c = 0; c < MAX_CHANNEL_COUNT; ++c) {
+                        pitch[frame * MAX_CHANNEL_COUNT + c] = c / 12.f;
+                    }
+                }
+                std::vector<float> output(frames * MAX_CHANNEL_COUNT);
+
+                std::string name = std::string(patch.name) + ", " + std::to_string(frames) + " frame blocks";
+                bench.runAudio("engine", name, channels, frames, [&] {
+                    engine.renderBlock(args, params, frames, pitch.data(), output.data());
+                    return output[0];
+                });
+            }
+        }
+    }
+}
+
+} // namespace ph
@@ -0,0 +1,37 @@
+#include <cstdio>
+#include "Bench.hpp"
+#include "MorphWavetable.hpp"
+#include "TraceRecorder.hpp"
+
+// Usage: spider_bench [filter] [trace file]. Runs every case whose "group/name" contains filter, or all of them.
+// Built with PH_TRACE, a trace file records the run as Chrome trace JSON.
+int main(int argc, char** argv) {
+    ph::morphWavetable.generate();
+
+#ifdef PH_TRACE
+    const char* tracePath = (argc > 2 && argv[2][0]) ? argv[2] : nullptr;
+    if (tracePath) {
+        ph::traceThreadName("bench");
+        ph::TraceRecorder::instance().start();
+    }
+#endif
+
+    ph::Bench bench(argc > 1 ? argv[1] : "");
+    ph::benchSineBackend(bench);
+    ph::benchSignalGenerator(bench);
+    ph::benchDirectedGraph(bench);
+    ph::benchSpiderEngine(bench);
+
+#ifdef PH_TRACE
+    if (tracePath) {
+        ph::TraceRecorder& recorder = ph::TraceRecorder::instance();
+        if (!recorder.stop(tracePath)) {
+            std::fprintf(stderr, "Could not write %s\n", tracePath);
+            return 1;
+        }
+        std::fprintf(stderr, "Wrote %s, %llu events dropped\n", tracePath,
+                     (unsigned long long)recorder.droppedEvents());
+    }
+#endif
+    return 0;
+}
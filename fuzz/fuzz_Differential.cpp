@@ -0,0 +1,65 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "Differential.hpp"
+
+// Differential fuzz target, see tests/Differential.hpp. The input picks the mode and the seed of a random case, and
+// a case with more samples past its mode's tolerance than the mode allows aborts.
+//
+// Built with -DPH_LIBFUZZER and -fsanitize=fuzzer this is a libFuzzer target. Otherwise it has its own main() that
+// runs a number of seeds through every mode, which is what `make fuzz` does.
+
+namespace {
+
+bool checkCase(uint64_t seed, ph::DifferentialMode mode) {
+    ph::DifferentialCase testCase = ph::randomDifferentialCase(seed, mode);
+    ph::DifferentialResult result = ph::runDifferential(testCase);
+
+    if (result.passed(mode)) {
+        return true;
+    }
+
+    std::fprintf(stderr,
+                 "%s, seed %llu, %d channels: difference of %g at frame %d of channel %d, %ld samples past the "
+                 "tolerance%s\n",
+                 ph::differentialModeName(mode), (unsigned long long)seed, testCase.channels, result.error,
+                 result.frame, result.channel, result.outliers, result.finite ? "" : ", non-finite frequency");
+    return false;
+}
+
+} // anonymous namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size < 1 + sizeof(uint64_t)) {
+        return 0;
+    }
+
+    ph::DifferentialMode mode = ph::DifferentialMode(data[0] % ph::DIFFERENTIAL_MODE_COUNT);
+    uint64_t seed;
+    std::memcpy(&seed, data + 1, sizeof(seed));
+
+    if (!checkCase(seed, mode)) {
+        std::abort();
+    }
+    return 0;
+}
+
+#ifndef PH_LIBFUZZER
+
+// Usage: spider_fuzz [runs] [first seed]
+int main(int argc, char** argv) {
+    long runs = argc > 1 ? std::atol(argv[1]) : 100;
+    uint64_t firstSeed = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 0;
+
+    int failures = 0;
+    for (uint64_t seed = firstSeed; seed < firstSeed + runs; ++seed) {
+        for (int mode = 0; mode < ph::DIFFERENTIAL_MODE_COUNT; ++mode) {
+            failures += !checkCase(seed, ph::DifferentialMode(mode));
+        }
+    }
+
+    std::printf("%ld seeds, %d failures\n", runs, failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+#endif
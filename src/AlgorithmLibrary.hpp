@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+
+namespace ph {
+
+// Routing of one of the built-in 6-operator algorithms, the 32 classic DX7 layouts. Operators are 0-based here, so
+// DX7 operator n is operator n - 1. In every layout a modulator has a higher number than the operators it
+// modulates, so evaluating from the last operator down is always a valid order. The DX7's fixed feedback loops are
+// left to each operator's own feedback knob, which makes some neighbouring algorithms (1 and 2, for example) route
+// the same.
+struct LibraryAlgorithm {
+    // modulators[op] is a mask of the operators that modulate op
+    uint8_t modulators[6];
+    uint8_t carriers;
+};
+
+namespace detail {
+
+// Mask of DX7 operator n
+constexpr uint8_t dx7(int n) {
+    return uint8_t(1 << (n - 1));
+}
+
+} // namespace detail
+
+constexpr int LIBRARY_ALGORITHM_COUNT = 32;
+
+constexpr LibraryAlgorithm LIBRARY_ALGORITHMS[LIBRARY_ALGORITHM_COUNT] = {
+    // 1, 2
+    {{detail::dx7(2), 0, detail::dx7(4), detail::dx7(5), detail::dx7(6), 0}, detail::dx7(1) | detail::dx7(3)},
+    {{detail::dx7(2), 0, detail::dx7(4), detail::dx7(5), detail::dx7(6), 0}, detail::dx7(1) | detail::dx7(3)},
+    // 3, 4
+    {{detail::dx7(2), detail::dx7(3), 0, detail::dx7(5), detail::dx7(6), 0}, detail::dx7(1) | detail::dx7(4)},
+    {{detail::dx7(2), detail::dx7(3), 0, detail::dx7(5), detail::dx7(6), 0}, detail::dx7(1) | detail::dx7(4)},
+    // 5, 6
+    {{detail::dx7(2), 0, detail::dx7(4), 0, detail::dx7(6), 0}, detail::dx7(1) | detail::dx7(3) | detail::dx7(5)},
+    {{detail::dx7(2), 0, detail::dx7(4), 0, detail::dx7(6), 0}, detail::dx7(1) | detail::dx7(3) | detail::dx7(5)},
+    // 7, 8, 9
+    {{detail::dx7(2), 0, detail::dx7(4) | detail::dx7(5), 0, detail::dx7(6), 0}, detail::dx7(1) | detail::dx7(3)},
+    {{detail::dx7(2), 0, detail::dx7(4) | detail::dx7(5), 0, detail::dx7(6), 0}, detail::dx7(1) | detail::dx7(3)},
+    {{detail::dx7(2), 0, detail::dx7(4) | detail::dx7(5), 0, detail::dx7(6), 0}, detail::dx7(1) | detail::dx7(3)},
+    // 10, 11
+    {{detail::dx7(2), detail::dx7(3), 0, detail::dx7(5) | detail::dx7(6), 0, 0}, detail::dx7(1) | detail::dx7(4)},
+    {{detail::dx7(2), detail::dx7(3), 0, detail::dx7(5) | detail::dx7(6), 0, 0}, detail::dx7(1) | detail::dx7(4)},
+    // 12, 13
+    {{detail::dx7(2), 0, detail::dx7(4) | detail::dx7(5) | detail::dx7(6), 0, 0, 0}, detail::dx7(1) | detail::dx7(3)},
+    {{detail::dx7(2), 0, detail::dx7(4) | detail::dx7(5) | detail::dx7(6), 0, 0, 0}, detail::dx7(1) | detail::dx7(3)},
+    // 14, 15
+    {{detail::dx7(2), 0, detail::dx7(4), detail::dx7(5) | detail::dx7(6), 0, 0}, detail::dx7(1) | detail::dx7(3)},
+    {{detail::dx7(2), 0, detail::dx7(4), detail::dx7(5) | detail::dx7(6), 0, 0}, detail::dx7(1) | detail::dx7(3)},
+    // 16, 17
+    {{detail::dx7(2) | detail::dx7(3) | detail::dx7(5), 0, detail::dx7(4), 0, detail::dx7(6), 0}, detail::dx7(1)},
+    {{detail::dx7(2) | detail::dx7(3) | detail::dx7(5), 0, detail::dx7(4), 0, detail::dx7(6), 0}, detail::dx7(1)},
+    // 18
+    {{detail::dx7(2) | detail::dx7(3) | detail::dx7(4), 0, 0, detail::dx7(5), detail::dx7(6), 0}, detail::dx7(1)},
+    // 19
+    {{detail::dx7(2), detail::dx7(3), 0, detail::dx7(6), detail::dx7(6), 0},
+     detail::dx7(1) | detail::dx7(4) | detail::dx7(5)},
+    // 20
+    {{detail::dx7(3), detail::dx7(3), 0, detail::dx7(5) | detail::dx7(6), 0, 0},
+     detail::dx7(1) | detail::dx7(2) | detail::dx7(4)},
+    // 21
+    {{detail::dx7(3), detail::dx7(3), 0, detail::dx7(6), detail::dx7(6), 0},
+     detail::dx7(1) | detail::dx7(2) | detail::dx7(4) | detail::dx7(5)},
+    // 22
+    {{detail::dx7(2), 0, detail::dx7(6), detail::dx7(6), detail::dx7(6), 0},
+     detail::dx7(1) | detail::dx7(3) | detail::dx7(4) | detail::dx7(5)},
+    // 23
+    {{0, detail::dx7(3), 0, detail::dx7(6), detail::dx7(6), 0},
+     detail::dx7(1) | detail::dx7(2) | detail::dx7(4) | detail::dx7(5)},
+    // 24
+    {{0, 0, detail::dx7(6), detail::dx7(6), detail::dx7(6), 0},
+     detail::dx7(1) | detail::dx7(2) | detail::dx7(3) | detail::dx7(4) | detail::dx7(5)},
+    // 25
+    {{0, 0, 0, detail::dx7(6), detail::dx7(6), 0},
+     detail::dx7(1) | detail::dx7(2) | detail::dx7(3) | detail::dx7(4) | detail::dx7(5)},
+    // 26, 27
+    {{0, detail::dx7(3), 0, detail::dx7(5) | detail::dx7(6), 0, 0}, detail::dx7(1) | detail::dx7(2) | detail::dx7(4)},
+    {{0, detail::dx7(3), 0, detail::dx7(5) | detail::dx7(6), 0, 0}, detail::dx7(1) | detail::dx7(2) | detail::dx7(4)},
+    // 28
+    {{detail::dx7(2), 0, detail::dx7(4), detail::dx7(5), 0, 0}, detail::dx7(1) | detail::dx7(3) | detail::dx7(6)},
+    // 29
+    {{0, 0, detail::dx7(4), 0, detail::dx7(6), 0},
+     detail::dx7(1) | detail::dx7(2) | detail::dx7(3) | detail::dx7(5)},
+    // 30
+    {{0, 0, detail::dx7(4), detail::dx7(5), 0, 0},
+     detail::dx7(1) | detail::dx7(2) | detail::dx7(3) | detail::dx7(6)},
+    // 31
+    {{0, 0, 0, 0, detail::dx7(6), 0},
+     detail::dx7(1) | detail::dx7(2) | detail::dx7(3) | detail::dx7(4) | detail::dx7(5)},
+    // 32
+    {{0, 0, 0, 0, 0, 0},
+     detail::dx7(1) | detail::dx7(2) | detail::dx7(3) | detail::dx7(4) | detail::dx7(5) | detail::dx7(6)},
+};
+
+// Replaces the edges of graph and the carriers with library algorithm `index`. Graph is a FixedDirectedGraph<6> or
+// anything else with clear() and addEdge(src, dest).
+template <typename Graph, typename Carriers>
+void loadLibraryAlgorithm(int index, Graph& graph, Carriers& carriers) {
+    const LibraryAlgorithm& algorithm = LIBRARY_ALGORITHMS[index];
+
+    graph.clear();
+    for (int op = 0; op < 6; ++op) {
+        carriers[op] = algorithm.carriers & (1 << op);
+
+        for (int mod = 0; mod < 6; ++mod) {
+            if (algorithm.modulators[op] & (1 << mod)) {
+                graph.addEdge(mod, op);
+            }
+        }
+    }
+}
+
+} // namespace ph
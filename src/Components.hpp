@@ -2,7 +2,8 @@
 
 #include <rack.hpp>
 #include "plugin.hpp"
-#include <functional>
+#include <array>
+#include <vector>
 
 using namespace rack;
 
@@ -33,40 +34,41 @@ struct ConnectionLight : ModuleLightWidget {
         end = Vec(this->box.size.x, this->box.size.y);
 
         length = std::hypot(this->box.size.x, this->box.size.y);
+
+        calculateDotPositions();
     }
 
     void drawBackground(const Widget::DrawArgs& args) override {
-        NVGcolor strokeColour = nvgRGB(30, 30, 30);
-
-        drawDottedLine(args.vg, [strokeColour](NVGcontext* vg, int, int, Vec pos) {
-            nvgBeginPath(vg);
-            nvgCircle(vg, pos.x, pos.y, 1.5f);
+        nvgBeginPath(args.vg);
+        for (const Vec& pos : dotPositions) {
+            nvgCircle(args.vg, pos.x, pos.y, 1.5f);
+        }
 
-            nvgFillColor(vg, strokeColour);
-            nvgFill(vg);
-        });
+        nvgFillColor(args.vg, nvgRGB(30, 30, 30));
+        nvgFill(args.vg);
     }
 
     void drawLight(const Widget::DrawArgs& args) override {
-        drawDottedLine(args.vg, [this](NVGcontext* vg, int i, int numDots, Vec pos) {
-            nvgBeginPath(vg);
-            nvgCircle(vg, pos.x, pos.y, 1.5f);
-
-            float dotAlpha = 1.f;
-            float t;
-            if (flipped) {
-                t = animTime + i * 0.1f;
-            } else {
-                t = animTime + (numDots - i) * 0.1f;
+        float brightness = getLight(0)->getBrightness();
+        if (brightness <= 0.f)
+            return;
+
+        // One path per group of dots that share an alpha
+        for (int group = 0; group < DOT_PATTERN_LENGTH; ++group) {
+            if (dotGroups[group].empty())
+                continue;
+
+            nvgBeginPath(args.vg);
+            for (const Vec& pos : dotGroups[group]) {
+                nvgCircle(args.vg, pos.x, pos.y, 1.5f);
             }
-            dotAlpha = 0.5f + 0.5f * std::sin(t * 2.0f * M_PI);
 
             auto segmentColour = OPERATOR_COLOURS[op];
-            segmentColour.a = getLight(0)->getBrightness() * dotAlpha;
+            segmentColour.a = brightness * dotAlphas[group];
 
-            nvgFillColor(vg, segmentColour);
-            nvgFill(vg);
-        });
+            nvgFillColor(args.vg, segmentColour);
+            nvgFill(args.vg);
+        }
     }
 
     void drawHalo(const Widget::DrawArgs& args) override {
@@ -76,61 +78,97 @@ struct ConnectionLight : ModuleLightWidget {
         if (rack::settings::haloBrightness <= 0.0f)
             return;
 
-        drawDottedLine(args.vg, [this](NVGcontext* vg, int i, int numDots, Vec pos) {
-            nvgBeginPath(vg);
-            nvgCircle(vg, pos.x, pos.y, 8.0f);
+        float brightness = getLight(0)->getBrightness();
+        if (brightness <= 0.f)
+            return;
 
-            float dotAlpha = 1.f;
-            float t;
-            if (flipped) {
-                t = animTime + i * 0.1f;
-            } else {
-                t = animTime + (numDots - i) * 0.1f;
-            }
-            dotAlpha = 0.5f + 0.5f * std::sin(t * 2.0f * M_PI);
+        if (!haloImage) {
+            createHaloImage(args.vg);
+        }
+
+        // One path per group of dots, like drawLight(). The halo texture repeats once per group spacing along the
+        // line, so a single paint lands a halo on every dot of the group.
+        Vec axis = dotStep.normalize();
+        Vec normal(-axis.y, axis.x);
+        float axisAngle = std::atan2(axis.y, axis.x);
+
+        for (int group = 0; group < DOT_PATTERN_LENGTH; ++group) {
+            if (dotGroups[group].empty())
+                continue;
 
             auto segmentColour = OPERATOR_COLOURS[op];
-            segmentColour.a = getLight(0)->getBrightness() * dotAlpha * rack::settings::haloBrightness;
+            segmentColour.a = brightness * dotAlphas[group] * rack::settings::haloBrightness;
+
+            nvgBeginPath(args.vg);
+            for (const Vec& pos : dotGroups[group]) {
+                nvgCircle(args.vg, pos.x, pos.y, HALO_RADIUS);
+            }
 
+            // The first dot sits in the middle of a tile
+            Vec origin = dotGroups[group][0].minus(axis.mult(haloSpacing / 2)).minus(normal.mult(HALO_RADIUS));
             NVGpaint paint =
-                nvgRadialGradient(vg, pos.x, pos.y, 2.0f, 8.0f, segmentColour, nvgRGBAf(0.f, 0.f, 0.f, 0.f));
-            nvgFillPaint(vg, paint);
-            nvgFill(vg);
-        });
+                nvgImagePattern(args.vg, origin.x, origin.y, haloSpacing, 2 * HALO_RADIUS, axisAngle, haloImage, 1.f);
+            // The texture is white, so the inner colour tints it
+            paint.innerColor = segmentColour;
+            paint.outerColor = segmentColour;
+            nvgFillPaint(args.vg, paint);
+            nvgFill(args.vg);
+        }
     }
 
-    std::vector<Vec> calculateDotPositions() {
-        const float dotSpacing = 7.0f;
+    // One tile of the halo texture: a white radial gradient, opaque within HALO_INNER_RADIUS of the centre and clear
+    // from HALO_RADIUS, in a tile as long as the spacing between dots of a group
+    void createHaloImage(NVGcontext* vg) {
+        int width = std::max(1, int(std::ceil(haloSpacing)));
+        int height = int(2 * HALO_RADIUS);
+        float scale = haloSpacing / width;
+
+        std::vector<unsigned char> pixels(width * height * 4);
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                float distance = std::hypot((x + 0.5f) * scale - haloSpacing / 2, y + 0.5f - HALO_RADIUS);
+                float alpha = 1.f - clamp((distance - HALO_INNER_RADIUS) / (HALO_RADIUS - HALO_INNER_RADIUS), 0.f, 1.f);
+
+                unsigned char* pixel = &pixels[(y * width + x) * 4];
+                pixel[0] = pixel[1] = pixel[2] = 255;
+                pixel[3] = static_cast<unsigned char>(255.f * alpha + 0.5f);
+            }
+        }
 
-        std::vector<Vec> positions;
-        float distance = std::sqrt(std::pow(end.x - start.x, 2) + std::pow(end.y - start.y, 2));
-        int numDots = static_cast<int>(distance / dotSpacing);
-        float dx = (end.x - start.x) / numDots;
-        float dy = (end.y - start.y) / numDots;
+        haloImage = nvgCreateImageRGBA(vg, width, height, NVG_IMAGE_REPEATX | NVG_IMAGE_REPEATY, pixels.data());
+    }
 
-        for (int i = 0; i <= numDots; ++i) {
-            float x = start.x + i * dx;
-            float y = start.y + i * dy;
-            positions.push_back(Vec(x, y));
+    void onContextDestroy(const ContextDestroyEvent& e) override {
+        if (haloImage) {
+            nvgDeleteImage(e.vg, haloImage);
+            haloImage = 0;
         }
+        ModuleLightWidget::onContextDestroy(e);
+    }
 
-        return positions;
+    ~ConnectionLight() override {
+        if (haloImage && APP && APP->window) {
+            nvgDeleteImage(APP->window->vg, haloImage);
+        }
     }
 
-    void drawDottedLine(NVGcontext* vg, std::function<void(NVGcontext*, int, int, Vec)> drawFunc) {
+    // Lays out the dots once. Dot i is DOT_PHASE_STEP further along the animation than its neighbour
+    // towards the destination, so dots DOT_PATTERN_LENGTH apart always have the same alpha and are grouped.
+    void calculateDotPositions() {
         const float dotSpacing = 6.0f;
 
-        std::vector<Vec> positions;
-        float distance = std::sqrt(std::pow(end.x - start.x, 2) + std::pow(end.y - start.y, 2));
-        int numDots = static_cast<int>(distance / dotSpacing);
+        int numDots = std::max(1, static_cast<int>(length / dotSpacing));
         float dx = (end.x - start.x) / numDots;
         float dy = (end.y - start.y) / numDots;
+        dotStep = Vec(dx, dy);
+        haloSpacing = DOT_PATTERN_LENGTH * dotStep.norm();
 
         for (int i = 0; i <= numDots; ++i) {
-            float x = start.x + i * dx;
-            float y = start.y + i * dy;
+            Vec pos(start.x + i * dx, start.y + i * dy);
+            dotPositions.push_back(pos);
 
-            drawFunc(vg, i, numDots, Vec(x, y));
+            int phase = flipped ? i : numDots - i;
+            dotGroups[phase % DOT_PATTERN_LENGTH].push_back(pos);
         }
     }
 
@@ -163,6 +201,11 @@ struct ConnectionLight : ModuleLightWidget {
             if (animTime >= 1.0f) {
                 animTime = 0.0f;
             }
+
+            for (int group = 0; group < DOT_PATTERN_LENGTH; ++group) {
+                float t = animTime + group * DOT_PHASE_STEP;
+                dotAlphas[group] = 0.5f + 0.5f * std::sin(t * 2.0f * M_PI);
+            }
         }
 
         ModuleLightWidget::step();
@@ -175,6 +218,23 @@ struct ConnectionLight : ModuleLightWidget {
 private:
     dsp::BooleanTrigger trigger;
 
+    // The animation phase steps by DOT_PHASE_STEP per dot and repeats every DOT_PATTERN_LENGTH dots
+    static constexpr float DOT_PHASE_STEP = 0.1f;
+    static constexpr int DOT_PATTERN_LENGTH = 10;
+
+    std::vector<Vec> dotPositions;
+    std::array<std::vector<Vec>, DOT_PATTERN_LENGTH> dotGroups;
+    std::array<float, DOT_PATTERN_LENGTH> dotAlphas = {};
+    // Offset from one dot to the next towards end
+    Vec dotStep;
+
+    static constexpr float HALO_INNER_RADIUS = 2.0f;
+    static constexpr float HALO_RADIUS = 8.0f;
+    // Distance between dots of the same group, the length of one tile of haloImage
+    float haloSpacing = 0.f;
+    // Created on the first halo draw, 0 until then
+    int haloImage = 0;
+
     bool flipped = false;
     Vec start = {0, 0};
     Vec end;
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <algorithm>
 #include <queue>
-#include <rack.hpp>
+#include <type_traits>
+#include <vector>
 
 namespace ph {
 
@@ -127,34 +129,7 @@ public:
         return std::find(reverseAdjList[src].begin(), reverseAdjList[src].end(), dest) != reverseAdjList[src].end();
     }
 
-    json_t* toJson() const {
-        json_t* rootJ = json_array();
-
-        for (const auto& list : adjList) {
-            json_t* sublistJ = json_array();
-            for (const auto& dest : list) {
-                json_array_append_new(sublistJ, json_integer(dest));
-            }
-            json_array_append_new(rootJ, sublistJ);
-        }
-
-        return rootJ;
-    }
-
-    void fromJson(json_t* rootJ) {
-        size_t size = json_array_size(rootJ);
-        adjList.resize(size);
-        reverseAdjList.resize(size);
-
-        for (size_t i = 0; i < size; ++i) {
-            json_t* sublistJ = json_array_get(rootJ, i);
-            size_t sublistSize = json_array_size(sublistJ);
-            for (size_t j = 0; j < sublistSize; ++j) {
-                adjList[i].push_back(json_integer_value(json_array_get(sublistJ, j)));
-                reverseAdjList[json_integer_value(json_array_get(sublistJ, j))].push_back(i);
-            }
-        }
-    }
+    int size() const { return int(adjList.size()); }
 
     void clear() {
         for (auto& list : adjList) {
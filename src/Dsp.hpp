@@ -0,0 +1,158 @@
+#pragma once
+
+// The parts of Rack the DSP core uses: the float_4 and int32_4 SIMD vectors and a few of their functions,
+// dsp::FREQ_C4, dsp::exp2_taylor5() and clamp(). Core headers include this instead of <rack.hpp>.
+//
+// In the plugin these are Rack's own, so core and module code share one float_4. Headless builds of the core
+// (PH_HEADLESS, see `make core`) have no Rack SDK and get the minimal SSE4.1 versions below instead, which have the
+// same interface for everything the core uses.
+
+#ifndef PH_HEADLESS
+
+#include <rack.hpp>
+
+namespace ph {
+namespace simd = rack::simd;
+namespace dsp = rack::dsp;
+using rack::math::clamp;
+} // namespace ph
+
+#else
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <smmintrin.h>
+
+namespace ph {
+namespace simd {
+
+struct int32_4;
+
+// Four floats in one SSE register. Comparisons return a mask with every bit of a lane set where they are true.
+struct float_4 {
+    union {
+        __m128 v;
+        float s[4];
+    };
+
+    float_4() = default;
+    float_4(__m128 v) : v(v) {}
+    float_4(float x) : v(_mm_set1_ps(x)) {}
+    float_4(float x1, float x2, float x3, float x4) : v(_mm_setr_ps(x1, x2, x3, x4)) {}
+    // Converts each lane of an int32_4
+    inline explicit float_4(int32_4 a);
+
+    static float_4 load(const float* x) { return float_4(_mm_loadu_ps(x)); }
+    void store(float* x) const { _mm_storeu_ps(x, v); }
+
+    float& operator[](int i) { return s[i]; }
+    const float& operator[](int i) const { return s[i]; }
+};
+
+struct int32_4 {
+    union {
+        __m128i v;
+        int32_t s[4];
+    };
+
+    int32_4() = default;
+    int32_4(__m128i v) : v(v) {}
+    int32_4(int32_t x) : v(_mm_set1_epi32(x)) {}
+    int32_4(int32_t x1, int32_t x2, int32_t x3, int32_t x4) : v(_mm_setr_epi32(x1, x2, x3, x4)) {}
+    // Converts each lane of a float_4, rounding towards zero
+    explicit int32_4(float_4 a) : v(_mm_cvttps_epi32(a.v)) {}
+
+    int32_t& operator[](int i) { return s[i]; }
+    const int32_t& operator[](int i) const { return s[i]; }
+};
+
+inline float_4::float_4(int32_4 a) : v(_mm_cvtepi32_ps(a.v)) {}
+
+inline float_4 operator+(float_4 a, float_4 b) { return _mm_add_ps(a.v, b.v); }
+inline float_4 operator-(float_4 a, float_4 b) { return _mm_sub_ps(a.v, b.v); }
+inline float_4 operator*(float_4 a, float_4 b) { return _mm_mul_ps(a.v, b.v); }
+inline float_4 operator/(float_4 a, float_4 b) { return _mm_div_ps(a.v, b.v); }
+inline float_4 operator-(float_4 a) { return _mm_sub_ps(_mm_setzero_ps(), a.v); }
+inline float_4 operator<(float_4 a, float_4 b) { return _mm_cmplt_ps(a.v, b.v); }
+inline float_4 operator<=(float_4 a, float_4 b) { return _mm_cmple_ps(a.v, b.v); }
+inline float_4 operator>(float_4 a, float_4 b) { return _mm_cmpgt_ps(a.v, b.v); }
+inline float_4 operator>=(float_4 a, float_4 b) { return _mm_cmpge_ps(a.v, b.v); }
+inline float_4 operator==(float_4 a, float_4 b) { return _mm_cmpeq_ps(a.v, b.v); }
+inline float_4 operator!=(float_4 a, float_4 b) { return _mm_cmpneq_ps(a.v, b.v); }
+inline float_4 operator&(float_4 a, float_4 b) { return _mm_and_ps(a.v, b.v); }
+inline float_4 operator|(float_4 a, float_4 b) { return _mm_or_ps(a.v, b.v); }
+inline float_4& operator+=(float_4& a, float_4 b) { return a = a + b; }
+inline float_4& operator-=(float_4& a, float_4 b) { return a = a - b; }
+inline float_4& operator*=(float_4& a, float_4 b) { return a = a * b; }
+inline float_4& operator/=(float_4& a, float_4 b) { return a = a / b; }
+
+inline int32_4 operator+(int32_4 a, int32_4 b) { return _mm_add_epi32(a.v, b.v); }
+inline int32_4 operator-(int32_4 a, int32_4 b) { return _mm_sub_epi32(a.v, b.v); }
+inline int32_4 operator&(int32_4 a, int32_4 b) { return _mm_and_si128(a.v, b.v); }
+inline int32_4 operator|(int32_4 a, int32_4 b) { return _mm_or_si128(a.v, b.v); }
+inline int32_4 operator<<(int32_4 a, int b) { return _mm_slli_epi32(a.v, b); }
+// Arithmetic shift, as for a signed int
+inline int32_4 operator>>(int32_4 a, int b) { return _mm_srai_epi32(a.v, b); }
+inline int32_4& operator+=(int32_4& a, int32_4 b) { return a = a + b; }
+inline int32_4& operator-=(int32_4& a, int32_4 b) { return a = a - b; }
+
+// Lanes of a where mask is set, b elsewhere
+inline float_4 ifelse(float_4 mask, float_4 a, float_4 b) { return _mm_blendv_ps(b.v, a.v, mask.v); }
+
+template <typename T>
+T ifelse(bool condition, T a, T b) {
+    return condition ? a : b;
+}
+
+inline float_4 floor(float_4 a) { return _mm_floor_ps(a.v); }
+inline float_4 fmin(float_4 a, float_4 b) { return _mm_min_ps(a.v, b.v); }
+inline float_4 fmax(float_4 a, float_4 b) { return _mm_max_ps(a.v, b.v); }
+inline float_4 fabs(float_4 a) { return _mm_andnot_ps(_mm_set1_ps(-0.f), a.v); }
+inline float_4 clamp(float_4 x, float_4 a, float_4 b) { return fmin(fmax(x, a), b); }
+
+// Scalar versions, so templates work on float and float_4 alike
+using std::floor;
+using std::fmin;
+using std::fmax;
+using std::fabs;
+
+inline float clamp(float x, float a, float b) {
+    return std::fmax(std::fmin(x, b), a);
+}
+
+} // namespace simd
+
+namespace dsp {
+
+const float FREQ_C4 = 261.6256f;
+
+// 2^i for a whole number i
+inline float exp2Integer(float i) {
+    return std::ldexp(1.f, int(i));
+}
+
+inline simd::float_4 exp2Integer(simd::float_4 i) {
+    // Built straight from the exponent bits
+    simd::int32_4 bits = (simd::int32_4(i) + simd::int32_4(127)) << 23;
+    return _mm_castsi128_ps(bits.v);
+}
+
+// 2^x from a degree 5 polynomial for the fractional part, exact at whole numbers. Relative error is about 1e-7.
+template <typename T>
+T exp2_taylor5(T x) {
+    T i = simd::floor(x);
+    T f = x - i;
+    T y = 1.f + f * (0.69315169f + f * (0.24015960f + f * (0.055817909f + f * (0.0089916980f + f * 0.0018791007f))));
+    return y * exp2Integer(i);
+}
+
+} // namespace dsp
+
+inline float clamp(float x, float a, float b) {
+    return simd::clamp(x, a, b);
+}
+
+} // namespace ph
+
+#endif
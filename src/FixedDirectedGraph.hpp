@@ -0,0 +1,168 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "DirectedGraph.hpp"
+
+namespace ph {
+
+// Directed graph with a fixed number of vertices. Cycles are allowed but loops (an edge from a vertex to itself) are
+// not. Edges are stored as one bitmask of successors and one of predecessors per vertex, alongside the transitive
+// closure of the graph, so reachability and strongly connected components are bit tests and no operation allocates
+// (apart from the std::vector returned by topologicalSort()).
+template <int N>
+class FixedDirectedGraph {
+    static_assert(N > 0 && N <= 32, "N must fit in a 32-bit mask");
+
+public:
+    typedef uint32_t Mask;
+
+    // Returns false, adding nothing, for a loop
+    bool addEdge(int src, int dest) {
+        if (src == dest) {
+            return false;
+        }
+
+        successors[src] |= bit(dest);
+        predecessors[dest] |= bit(src);
+
+        // Everything that reaches src (and src itself) now reaches dest and everything dest reaches. If dest already
+        // reached src the new paths around the cycle add nothing beyond that.
+        Mask reachableFromDest = bit(dest) | reachable[dest];
+        for (int v = 0; v < N; ++v) {
+            if (v == src || canReach(v, src)) {
+                reachable[v] |= reachableFromDest;
+            }
+        }
+
+        return true;
+    }
+
+    // Removes the edge if it exists and adds it otherwise, returning whether it exists afterwards. An edge whose
+    // reverse exists is added alongside it, making a two vertex cycle.
+    bool toggleEdge(int src, int dest) {
+        if (hasEdge(src, dest)) {
+            removeEdge(src, dest);
+            return false;
+        }
+        return addEdge(src, dest);
+    }
+
+    void removeEdge(int src, int dest) {
+        successors[src] &= ~bit(dest);
+        predecessors[dest] &= ~bit(src);
+
+        // Reachability can't be removed incrementally as there may be another path, so rebuild it
+        updateClosure();
+    }
+
+    bool hasEdge(int src, int dest) const { return successors[src] & bit(dest); }
+    bool hasReverseEdge(int src, int dest) const { return predecessors[src] & bit(dest); }
+
+    // True if there is a path of at least one edge from src to dest
+    bool canReach(int src, int dest) const { return reachable[src] & bit(dest); }
+
+    Mask getSuccessors(int vertex) const { return successors[vertex]; }
+    Mask getPredecessors(int vertex) const { return predecessors[vertex]; }
+
+    // The strongly connected component containing vertex: itself and every vertex on a cycle through it
+    Mask getComponent(int vertex) const {
+        Mask component = bit(vertex);
+        for (int v = 0; v < N; ++v) {
+            if (canReach(vertex, v) && canReach(v, vertex)) {
+                component |= bit(v);
+            }
+        }
+        return component;
+    }
+
+    bool isCyclic() const {
+        for (int v = 0; v < N; ++v) {
+            if (canReach(v, v)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Writes the vertices in topological order of their strongly connected components, so an edge only points back
+    // to an earlier vertex when both are on a cycle. Components with no remaining predecessors are taken together
+    // and their vertices in ascending order. For an acyclic graph this is an ordinary topological order.
+    void topologicalSort(std::array<int, N>& order) const {
+        // Predecessors of each vertex's component from outside it
+        std::array<Mask, N> componentPredecessors;
+        for (int v = 0; v < N; ++v) {
+            Mask component = getComponent(v);
+            componentPredecessors[v] = 0;
+            for (int u = 0; u < N; ++u) {
+                if (component & bit(u)) {
+                    componentPredecessors[v] |= predecessors[u];
+                }
+            }
+            componentPredecessors[v] &= ~component;
+        }
+
+        Mask remaining = allVertices();
+        int count = 0;
+
+        while (remaining) {
+            Mask ready = 0;
+            for (int v = 0; v < N; ++v) {
+                if ((remaining & bit(v)) && !(componentPredecessors[v] & remaining)) {
+                    ready |= bit(v);
+                }
+            }
+
+            for (int v = 0; v < N; ++v) {
+                if (ready & bit(v)) {
+                    order[count++] = v;
+                }
+            }
+
+            remaining &= ~ready;
+        }
+    }
+
+    std::vector<int> topologicalSort() const {
+        std::array<int, N> order;
+        topologicalSort(order);
+        return std::vector<int>(order.begin(), order.end());
+    }
+
+    int size() const { return N; }
+
+    void clear() {
+        successors.fill(0);
+        predecessors.fill(0);
+        reachable.fill(0);
+    }
+
+    bool operator==(const FixedDirectedGraph<N>& other) const {
+        return successors == other.successors && predecessors == other.predecessors;
+    }
+
+private:
+    static Mask bit(int vertex) { return Mask(1) << vertex; }
+    static Mask allVertices() { return (N == 32) ? ~Mask(0) : (Mask(1) << N) - 1; }
+
+    // Warshall's algorithm, which unlike a walk in topological order works on graphs with cycles
+    void updateClosure() {
+        reachable = successors;
+        for (int via = 0; via < N; ++via) {
+            for (int v = 0; v < N; ++v) {
+                if (reachable[v] & bit(via)) {
+                    reachable[v] |= reachable[via];
+                }
+            }
+        }
+    }
+
+    std::array<Mask, N> successors = {};
+    std::array<Mask, N> predecessors = {};
+
+    // reachable[v] has a bit set for every vertex reachable from v, including v itself if it is on a cycle
+    std::array<Mask, N> reachable = {};
+};
+
+} // namespace ph
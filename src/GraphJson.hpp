@@ -0,0 +1,43 @@
+#pragma once
+
+#include <algorithm>
+#include <rack.hpp>
+
+namespace ph {
+
+// Saves and loads the edges of a DirectedGraph or FixedDirectedGraph. The graphs themselves are part of the DSP core
+// and don't know about JSON; this is the plugin side. The format is one array of destinations per vertex.
+template <typename Graph>
+json_t* graphToJson(const Graph& graph) {
+    json_t* rootJ = json_array();
+    for (int src = 0; src < graph.size(); ++src) {
+        json_t* edgesJ = json_array();
+        for (int dest = 0; dest < graph.size(); ++dest) {
+            if (graph.hasEdge(src, dest)) {
+                json_array_append_new(edgesJ, json_integer(dest));
+            }
+        }
+        json_array_append_new(rootJ, edgesJ);
+    }
+    return rootJ;
+}
+
+// Replaces the edges of graph with those in rootJ. Vertices past the end of the graph and edges the graph refuses
+// are skipped.
+template <typename Graph>
+void graphFromJson(Graph& graph, json_t* rootJ) {
+    graph.clear();
+
+    size_t size = std::min(json_array_size(rootJ), size_t(graph.size()));
+    for (size_t src = 0; src < size; ++src) {
+        json_t* edgesJ = json_array_get(rootJ, src);
+        for (size_t i = 0; i < json_array_size(edgesJ); ++i) {
+            int dest = json_integer_value(json_array_get(edgesJ, i));
+            if (dest >= 0 && dest < graph.size()) {
+                graph.addEdge(src, dest);
+            }
+        }
+    }
+}
+
+} // namespace ph
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include "Dsp.hpp"
+
+namespace ph {
+
+// Zeroth order modified Bessel function of the first kind, for the Kaiser window
+inline float besselI0(float x) {
+    float sum = 1.f;
+    float term = 1.f;
+    for (int k = 1; k < 20; ++k) {
+        float factor = x / (2.f * k);
+        term *= factor * factor;
+        sum += term;
+    }
+    return sum;
+}
+
+// Halves the sample rate with a Kaiser-windowed half-band FIR of 4 * K - 1 taps. Every other tap of a half-band
+// filter is zero apart from the centre one, so only K coefficients (plus the centre tap of 0.5) are multiplied, and
+// the filter only runs once per output sample.
+// T is float or simd::float_4 to filter four polyphony channels at once.
+template <typename T, int K>
+struct THalfBandDecimator {
+    static constexpr int LENGTH = 4 * K - 1;
+    static constexpr int CENTRE = 2 * K - 1;
+
+    // Kaiser window beta for about 60dB of stopband attenuation
+    THalfBandDecimator(float beta = 6.f) {
+        float sum = 0.f;
+        for (int j = 0; j < K; ++j) {
+            int offset = 2 * j + 1;
+            float sinc = ((j % 2 == 0) ? 1.f : -1.f) / (float(M_PI) * offset);
+
+            float r = float(offset) / CENTRE;
+            float window = besselI0(beta * std::sqrt(1.f - r * r)) / besselI0(beta);
+
+            coefficients[j] = sinc * window;
+            sum += coefficients[j];
+        }
+
+        // Unity gain at DC: the centre tap is 0.5 and each coefficient appears twice
+        for (int j = 0; j < K; ++j) {
+            coefficients[j] *= 0.25f / sum;
+        }
+    }
+
+    // Takes two consecutive input samples and returns one output sample
+    T process(T x0, T x1) {
+        push(x0);
+        push(x1);
+
+        // Oldest to newest
+        const T* window = &history[position];
+
+        T y = 0.5f * window[CENTRE];
+        for (int j = 0; j < K; ++j) {
+            y += coefficients[j] * (window[CENTRE - 2 * j - 1] + window[CENTRE + 2 * j + 1]);
+        }
+        return y;
+    }
+
+    void reset() {
+        history.fill(T(0.f));
+        position = 0;
+    }
+
+    std::array<float, K> coefficients;
+
+private:
+    // Every sample is written twice so the last LENGTH samples are always contiguous
+    void push(T x) {
+        history[position] = x;
+        history[position + LENGTH] = x;
+        position = (position + 1) % LENGTH;
+    }
+
+    std::array<T, 2 * LENGTH> history = {};
+    int position = 0;
+};
+
+// Decimates 2x, 4x or 8x oversampled signals with a chain of half-band stages. Only the last stage needs a narrow
+// transition band (about 18kHz to 30kHz at 48kHz), earlier stages run at higher rates where it can be much wider so
+// they use fewer taps.
+template <typename T = float>
+struct TOversamplingDecimator {
+    static constexpr int MAX_FACTOR = 8;
+
+    // Takes factor input samples (1, 2, 4 or 8) and returns one. The input is used as scratch space.
+    T process(T* in, int factor) {
+        if (factor >= 8) {
+            for (int i = 0; i < 4; ++i) {
+                in[i] = stage8.process(in[2 * i], in[2 * i + 1]);
+            }
+        }
+
+        if (factor >= 4) {
+            for (int i = 0; i < 2; ++i) {
+                in[i] = stage4.process(in[2 * i], in[2 * i + 1]);
+            }
+        }
+
+        if (factor >= 2) {
+            return stage2.process(in[0], in[1]);
+        }
+
+        return in[0];
+    }
+
+    void reset() {
+        stage8.reset();
+        stage4.reset();
+        stage2.reset();
+    }
+
+    THalfBandDecimator<T, 3> stage8;
+    THalfBandDecimator<T, 4> stage4;
+    THalfBandDecimator<T, 10> stage2;
+};
+
+} // namespace ph
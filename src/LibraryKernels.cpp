@@ -0,0 +1,130 @@
+#include "AlgorithmLibrary.hpp"
+#include "SpiderEngine.hpp"
+
+// The library algorithms' kernels, see SpiderEngine::processLibraryFrame(). They live apart from SpiderEngine.cpp so
+// their inlining doesn't eat into the generic engine's.
+
+namespace ph {
+
+namespace {
+
+constexpr bool sameRouting(const LibraryAlgorithm& a, const LibraryAlgorithm& b) {
+    return a.carriers == b.carriers && a.modulators[0] == b.modulators[0] && a.modulators[1] == b.modulators[1] &&
+           a.modulators[2] == b.modulators[2] && a.modulators[3] == b.modulators[3] &&
+           a.modulators[4] == b.modulators[4] && a.modulators[5] == b.modulators[5];
+}
+
+// First library algorithm from `from` on routed the same as algorithm a. Algorithms that only differ in the DX7's
+// fixed feedback loops share a kernel.
+constexpr int firstWithRouting(int a, int from = 0) {
+    return sameRouting(LIBRARY_ALGORITHMS[from], LIBRARY_ALGORITHMS[a]) ? from : firstWithRouting(a, from + 1);
+}
+
+// Position of modulator mod among the modulators in mask, which is where RoutingSchedule::compile() lists it
+constexpr int modulatorIndex(int mask, int mod) {
+    return (mod == 0) ? 0 : (mask & 1) + modulatorIndex(mask >> 1, mod - 1);
+}
+
+// Adds the modulation of operator OP by MOD and the operators after it in library algorithm A. Each pair is known
+// at compile time, so the sum unrolls to the algorithm's own connections.
+template <int A, int OP, int MOD>
+struct LibraryModulation {
+    static void add(simd::float_4& freq, const RoutingSchedule<OPERATOR_COUNT>& schedule,
+                    const SpiderEngine::VoiceGroup& voices) {
+        if (LIBRARY_ALGORITHMS[A].modulators[OP] & (1 << MOD)) {
+            const int i = modulatorIndex(LIBRARY_ALGORITHMS[A].modulators[OP], MOD);
+            freq += 5.f * schedule.modulationDepths[OP][i] * voices.freqs[MOD] * voices.outs[MOD];
+        }
+        LibraryModulation<A, OP, MOD + 1>::add(freq, schedule, voices);
+    }
+};
+
+template <int A, int OP>
+struct LibraryModulation<A, OP, OPERATOR_COUNT> {
+    static void add(simd::float_4&, const RoutingSchedule<OPERATOR_COUNT>&, const SpiderEngine::VoiceGroup&) {}
+};
+
+// Runs the live operators from OP down to the first, as SpiderEngine::processOperator() does. A library algorithm's
+// modulators are always numbered above the operators they modulate, so this order gives the same output as the
+// schedule's.
+template <int A, int OP>
+struct LibraryOperators {
+    static void run(SpiderEngine& engine, const RenderArgs& args, SpiderEngine::VoiceGroup& voices,
+                    simd::float_4 baseFreq,
+                    const std::array<SpiderEngine::OperatorControls, OPERATOR_COUNT>& frameControls, uint32_t live) {
+        if (live & (1u << OP)) {
+            PH_PERF_SCOPE(engine.perf.operators[OP]);
+
+            const SpiderEngine::OperatorControls& opControls = frameControls[OP];
+            simd::float_4 freq = baseFreq * opControls.coarseRatio;
+            freq *= opControls.fineRatio;
+            LibraryModulation<A, OP, 0>::add(freq, engine.schedule, voices);
+            engine.generateOperator(OP, freq, opControls, args, voices);
+        }
+        LibraryOperators<A, OP - 1>::run(engine, args, voices, baseFreq, frameControls, live);
+    }
+};
+
+template <int A>
+struct LibraryOperators<A, -1> {
+    static void run(SpiderEngine&, const RenderArgs&, SpiderEngine::VoiceGroup&, simd::float_4,
+                    const std::array<SpiderEngine::OperatorControls, OPERATOR_COUNT>&, uint32_t) {}
+};
+
+// Adds the carriers from OP up of library algorithm A to sum, in the order processFrame() adds them
+template <int A, int OP>
+struct LibraryCarriers {
+    static simd::float_4 add(simd::float_4 sum, const SpiderEngine::VoiceGroup& voices) {
+        if (LIBRARY_ALGORITHMS[A].carriers & (1 << OP)) {
+            sum += voices.outs[OP];
+        }
+        return LibraryCarriers<A, OP + 1>::add(sum, voices);
+    }
+};
+
+template <int A>
+struct LibraryCarriers<A, OPERATOR_COUNT> {
+    static simd::float_4 add(simd::float_4 sum, const SpiderEngine::VoiceGroup&) { return sum; }
+};
+
+} // anonymous namespace
+
+// Flattened, so all six generators are inlined whatever the compiler's inlining budget. Left to it, a unit of
+// kernels runs out of budget and calls the generators, which is slower than the generic engine.
+template <int A>
+__attribute__((flatten)) simd::float_4
+SpiderEngine::processLibraryFrame(const RenderArgs& args, VoiceGroup& voices, simd::float_4 baseFreq,
+                                  const std::array<OperatorControls, OPERATOR_COUNT>& frameControls,
+                                  const OperatorList& operators) {
+    LibraryOperators<A, OPERATOR_COUNT - 1>::run(*this, args, voices, baseFreq, frameControls, operators.mask);
+    return LibraryCarriers<A, 0>::add(0.f, voices);
+}
+
+namespace {
+
+// Fills kernels[A ..] with the kernel of each library algorithm from A on
+template <int A>
+struct LibraryKernels {
+    static void fill(std::array<SpiderEngine::FrameKernel, LIBRARY_ALGORITHM_COUNT>& kernels) {
+        kernels[A] = &SpiderEngine::processLibraryFrame<firstWithRouting(A)>;
+        LibraryKernels<A + 1>::fill(kernels);
+    }
+};
+
+template <>
+struct LibraryKernels<LIBRARY_ALGORITHM_COUNT> {
+    static void fill(std::array<SpiderEngine::FrameKernel, LIBRARY_ALGORITHM_COUNT>&) {}
+};
+
+} // anonymous namespace
+
+SpiderEngine::FrameKernel SpiderEngine::libraryKernel(int index) {
+    static const std::array<FrameKernel, LIBRARY_ALGORITHM_COUNT> kernels = [] {
+        std::array<FrameKernel, LIBRARY_ALGORITHM_COUNT> kernels;
+        LibraryKernels<0>::fill(kernels);
+        return kernels;
+    }();
+    return (index >= 0 && index < LIBRARY_ALGORITHM_COUNT) ? kernels[index] : nullptr;
+}
+
+} // namespace ph
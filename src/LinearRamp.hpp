@@ -0,0 +1,44 @@
+#pragma once
+
+namespace ph {
+
+// Moves linearly from its current value to a target over a number of frames. Used to smooth
+// params and CV that are only sampled at control rate.
+struct LinearRamp {
+    // frames <= 0 jumps straight to the target
+    void setTarget(float newTarget, int frames) {
+        target = newTarget;
+
+        if (frames <= 0 || value == target) {
+            value = target;
+            step = 0.f;
+            remaining = 0;
+            return;
+        }
+
+        step = (target - value) / frames;
+        remaining = frames;
+    }
+
+    // Value of the ramp `frame` frames into the current block, without advancing it
+    float at(int frame) const { return (frame + 1 < remaining) ? value + step * (frame + 1) : target; }
+
+    void advance(int frames) {
+        if (frames >= remaining) {
+            value = target;
+            remaining = 0;
+        } else {
+            value += step * frames;
+            remaining -= frames;
+        }
+    }
+
+    bool isRamping() const { return remaining > 0; }
+
+    float value = 0.f;
+    float target = 0.f;
+    float step = 0.f;
+    int remaining = 0;
+};
+
+} // namespace ph
@@ -0,0 +1,5 @@
+#include "MorphWavetable.hpp"
+
+namespace ph {
+MorphWavetable morphWavetable;
+} // namespace ph
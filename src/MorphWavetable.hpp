@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "Dsp.hpp"
+
+namespace ph {
+
+// Band-limited version of morphWave(). Each octave mipmap level holds five single cycle slices,
+// sine -> triangle -> saw -> square -> sine, built from their Fourier series. morphWave() crossfades
+// linearly between neighbouring waveforms, so interpolating between slices gives the same morph.
+class MorphWavetable {
+public:
+    static constexpr int SIZE = 2048;
+    static constexpr int SLICES = 5;
+    static constexpr int LEVELS = 10;
+
+    // Harmonics in level 0, each level above has half as many
+    static constexpr int MAX_HARMONICS = 512;
+
+    void generate() {
+        samples.assign(LEVELS * SLICES * (SIZE + 1), 0.f);
+
+        std::vector<float> sinTable(SIZE);
+        for (int n = 0; n < SIZE; ++n) {
+            sinTable[n] = std::sin(2.0 * M_PI * n / SIZE);
+        }
+
+        for (int level = 0; level < LEVELS; ++level) {
+            int harmonics = MAX_HARMONICS >> level;
+
+            float* sine = mutableSlice(level, 0);
+            float* triangle = mutableSlice(level, 1);
+            float* saw = mutableSlice(level, 2);
+            float* square = mutableSlice(level, 3);
+
+            for (int n = 0; n < SIZE; ++n) {
+                sine[n] = sinTable[n];
+            }
+
+            for (int k = 1; k <= harmonics; ++k) {
+                float sawAmplitude = ((k % 2) ? 2.f : -2.f) / (float(M_PI) * k);
+                float triangleAmplitude = (k % 2) ? -8.f / (float(M_PI * M_PI) * k * k) : 0.f;
+                float squareAmplitude = (k % 2) ? 4.f / (float(M_PI) * k) : 0.f;
+
+                for (int n = 0; n < SIZE; ++n) {
+                    int index = (k * n) % SIZE;
+                    float sinValue = sinTable[index];
+                    float cosValue = sinTable[(index + SIZE / 4) % SIZE];
+
+                    saw[n] += sawAmplitude * sinValue;
+                    triangle[n] += triangleAmplitude * cosValue;
+                    square[n] += squareAmplitude * sinValue;
+                }
+            }
+
+            std::copy(sine, sine + SIZE, mutableSlice(level, 4));
+
+            // Wrap one sample so interpolation never needs to
+            for (int s = 0; s < SLICES; ++s) {
+                mutableSlice(level, s)[SIZE] = mutableSlice(level, s)[0];
+            }
+        }
+    }
+
+    bool isGenerated() const { return !samples.empty(); }
+
+    // Lowest level with no harmonics above Nyquist for a phase increment of `increment` cycles per sample
+    static int levelFor(float increment) {
+        float harmonicsAtNyquist = 2.f * MAX_HARMONICS * std::abs(increment);
+        if (harmonicsAtNyquist < 1.f) {
+            return 0;
+        }
+        // ceil(log2(harmonicsAtNyquist))
+        int level = std::ilogb(harmonicsAtNyquist);
+        if (std::ldexp(1.f, level) < harmonicsAtNyquist) {
+            level++;
+        }
+        return std::min(level, LEVELS - 1);
+    }
+
+    // phase in [0, 1), wavePos in [0, 1]
+    float lookupLevel(float phase, float wavePos, int level) const {
+        float x = wavePos * (SLICES - 1);
+        int s = std::min(int(x), SLICES - 2);
+        float slicePos = x - s;
+
+        float p = phase * SIZE;
+        int i = std::min(int(p), SIZE - 1);
+        float phasePos = p - i;
+
+        const float* a = slice(level, s) + i;
+        const float* b = slice(level, s + 1) + i;
+
+        float fromA = a[0] + phasePos * (a[1] - a[0]);
+        float fromB = b[0] + phasePos * (b[1] - b[0]);
+        return fromA + slicePos * (fromB - fromA);
+    }
+
+    // Picks the level for each lane from its phase increment. SSE has no gather so lanes are looked up one at a time.
+    simd::float_4 lookup(simd::float_4 phase, simd::float_4 wavePos, simd::float_4 increment) const {
+        simd::float_4 result;
+        for (int lane = 0; lane < 4; ++lane) {
+            result[lane] = lookupLevel(phase[lane], wavePos[lane], levelFor(increment[lane]));
+        }
+        return result;
+    }
+
+    float lookup(float phase, float wavePos, float increment) const {
+        return lookupLevel(phase, wavePos, levelFor(increment));
+    }
+
+    const float* slice(int level, int s) const { return &samples[(level * SLICES + s) * (SIZE + 1)]; }
+
+private:
+    float* mutableSlice(int level, int s) { return &samples[(level * SLICES + s) * (SIZE + 1)]; }
+
+    std::vector<float> samples;
+};
+
+// Shared by every instance, defined in MorphWavetable.cpp and generated in init()
+extern MorphWavetable morphWavetable;
+
+} // namespace ph
@@ -0,0 +1,58 @@
+#include "PerfCounters.hpp"
+
+#ifdef PH_PERF_COUNTERS
+
+#include <cstdlib>
+#include <new>
+
+namespace ph {
+thread_local std::atomic<uint64_t>* perfAllocationCounter = nullptr;
+} // namespace ph
+
+// Replacements for the global allocation functions that count into ph::perfAllocationCounter. They allocate with
+// malloc() like the standard ones, so memory can still be freed by either. Rack loads plugins locally, so these only
+// see the plugin's own allocations; on Linux the Makefile links with -Bsymbolic-functions so the plugin's calls bind
+// to them rather than to the host's.
+
+namespace {
+
+void* countedAllocate(std::size_t size) {
+    std::atomic<uint64_t>* counter = ph::perfAllocationCounter;
+    if (counter) {
+        counter->store(counter->load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    void* p = std::malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+} // anonymous namespace
+
+void* operator new(std::size_t size) {
+    return countedAllocate(size);
+}
+
+void* operator new[](std::size_t size) {
+    return countedAllocate(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+#endif
@@ -0,0 +1,161 @@
+#pragma once
+
+// Optional hot path instrumentation, built in with PH_PERF_COUNTERS (`make PERF_COUNTERS=1`). Without it the
+// PH_PERF_* macros expand to nothing and none of this is compiled.
+
+#ifdef PH_PERF_COUNTERS
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace ph {
+
+// CPU cycles from the time stamp counter where there is one, nanoseconds elsewhere. PerfClock converts them.
+inline uint64_t perfTicks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+}
+
+// Converts ticks to nanoseconds by timing them against the steady clock since it was created
+struct PerfClock {
+    PerfClock() : startTicks(perfTicks()), startTime(std::chrono::steady_clock::now()) {}
+
+    double ticksPerNs() const {
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - startTime).count();
+        return ns > 0.0 ? (perfTicks() - startTicks) / ns : 1.0;
+    }
+
+    uint64_t startTicks;
+    std::chrono::steady_clock::time_point startTime;
+};
+
+// Calls of one instrumented region and the ticks spent in them. Only one thread may add(), any thread may read, so
+// the counts are plain relaxed stores and never need a read-modify-write.
+struct PerfCounter {
+    struct Snapshot {
+        uint64_t calls;
+        uint64_t ticks;
+        uint64_t maxTicks;
+
+        double meanTicks() const { return calls ? double(ticks) / calls : 0.0; }
+    };
+
+    void add(uint64_t elapsed) {
+        calls.store(calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        ticks.store(ticks.load(std::memory_order_relaxed) + elapsed, std::memory_order_relaxed);
+        if (elapsed > maxTicks.load(std::memory_order_relaxed)) {
+            maxTicks.store(elapsed, std::memory_order_relaxed);
+        }
+    }
+
+    Snapshot snapshot() const {
+        Snapshot s;
+        s.calls = calls.load(std::memory_order_relaxed);
+        s.ticks = ticks.load(std::memory_order_relaxed);
+        s.maxTicks = maxTicks.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    // Only from the thread that adds
+    void reset() {
+        calls.store(0, std::memory_order_relaxed);
+        ticks.store(0, std::memory_order_relaxed);
+        maxTicks.store(0, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> ticks{0};
+    std::atomic<uint64_t> maxTicks{0};
+};
+
+// Adds the ticks from construction to destruction to a counter
+struct PerfScope {
+    explicit PerfScope(PerfCounter& counter) : counter(counter), start(perfTicks()) {}
+    ~PerfScope() { counter.add(perfTicks() - start); }
+
+    PerfCounter& counter;
+    uint64_t start;
+};
+
+// Allocations made through operator new on this thread while a PerfAllocationScope is alive are counted in its
+// counter, see the replacement operator new in PerfCounters.cpp. That includes the standard containers and strings
+// the plugin uses.
+extern thread_local std::atomic<uint64_t>* perfAllocationCounter;
+
+struct PerfAllocationScope {
+    explicit PerfAllocationScope(std::atomic<uint64_t>& counter) : previous(perfAllocationCounter) {
+        perfAllocationCounter = &counter;
+    }
+    ~PerfAllocationScope() { perfAllocationCounter = previous; }
+
+    std::atomic<uint64_t>* previous;
+};
+
+// Every counter of one Spider. The audio thread owns the audio counters and the UI thread the edit counters. Either
+// thread may read them all, and the UI resets the audio counters by asking the audio thread to.
+template <int OPERATOR_COUNT>
+struct SpiderPerf {
+    // Audio thread, once per process() before anything is counted
+    void beginFrame() {
+        if (resetRequested.exchange(false, std::memory_order_acquire)) {
+            process.reset();
+            processOperators.reset();
+            for (auto& counter : operators) {
+                counter.reset();
+            }
+            scheduleLatency.reset();
+            audioAllocations.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // UI thread
+    void reset() {
+        resetRequested.store(true, std::memory_order_release);
+        edit.reset();
+        editAllocations.store(0, std::memory_order_relaxed);
+    }
+
+    // Audio thread
+    PerfCounter process;
+    PerfCounter processOperators;
+    std::array<PerfCounter, OPERATOR_COUNT> operators;
+    // Ticks from the UI publishing a schedule to the audio thread picking it up
+    PerfCounter scheduleLatency;
+    std::atomic<uint64_t> audioAllocations{0};
+
+    // UI thread
+    PerfCounter edit;
+    std::atomic<uint64_t> editAllocations{0};
+    // perfTicks() when the last schedule was published
+    std::atomic<uint64_t> publishTicks{0};
+
+    std::atomic<bool> resetRequested{false};
+    PerfClock clock;
+};
+
+} // namespace ph
+
+#define PH_PERF_CONCAT_(a, b) a##b
+#define PH_PERF_CONCAT(a, b) PH_PERF_CONCAT_(a, b)
+// Times the rest of the enclosing scope into a PerfCounter
+#define PH_PERF_SCOPE(counter) ::ph::PerfScope PH_PERF_CONCAT(perfScope, __LINE__)(counter)
+// Counts allocations made in the rest of the enclosing scope
+#define PH_PERF_ALLOCATIONS(counter) ::ph::PerfAllocationScope PH_PERF_CONCAT(perfAllocations, __LINE__)(counter)
+
+#else
+
+#define PH_PERF_SCOPE(counter)
+#define PH_PERF_ALLOCATIONS(counter)
+
+#endif
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "DirectedGraph.hpp"
+#include "FixedDirectedGraph.hpp"
+
+namespace ph {
+
+// Flat, fixed-size copy of an algorithm graph for the audio loop. It is compiled whenever the
+// graph is edited so rendering never has to query the graph.
+// Graph is a DirectedGraph<int> or FixedDirectedGraph<N>.
+//
+// The graph may have cycles if the order is a topological order of its strongly connected components. A modulator
+// that comes later in the order than the operator it modulates is fed back around a cycle, and the operator reads
+// its output from the previous sample. That is simply the output the modulator still holds when the operator is
+// evaluated, so loops need no extra state and no extra work.
+template <int N>
+struct RoutingSchedule {
+    template <typename Graph, typename Order>
+    void compile(const Graph& graph, const Order& topologicalOrder) {
+        libraryAlgorithm = -1;
+        for (int i = 0; i < N; ++i) {
+            order[i] = topologicalOrder[i];
+
+            modulatorCounts[i] = 0;
+            for (int mod = 0; mod < N; ++mod) {
+                if (graph.hasEdge(mod, i)) {
+                    modulationDepths[i][modulatorCounts[i]] = 1.f;
+                    modulators[i][modulatorCounts[i]++] = mod;
+                }
+            }
+        }
+
+        std::array<int, N> position;
+        for (int i = 0; i < N; ++i) {
+            position[order[i]] = i;
+        }
+
+        // Walking the order, an operator's modulators and the operators it feeds back to already have levels. It goes
+        // on a later level than its modulators, and on no earlier level than the operators it feeds back to so it is
+        // still evaluated after they read its previous output.
+        cyclic = false;
+        for (int i = 0; i < N; ++i) {
+            int op = order[i];
+            levels[op] = 0;
+            for (int j = 0; j < modulatorCounts[op]; ++j) {
+                int mod = modulators[op][j];
+                fedBack[op][j] = position[mod] > i;
+                if (fedBack[op][j]) {
+                    cyclic = true;
+                } else {
+                    levels[op] = std::max(levels[op], levels[mod] + 1);
+                }
+            }
+
+            for (int j = 0; j < i; ++j) {
+                if (graph.hasEdge(op, order[j])) {
+                    levels[op] = std::max(levels[op], levels[order[j]]);
+                }
+            }
+        }
+    }
+
+    // isCarrier[op] is true for every operator summed into the output
+    template <typename Carriers>
+    void setCarriers(const Carriers& isCarrier) {
+        carrierCount = 0;
+        carrierMask = 0;
+        for (int op = 0; op < N; ++op) {
+            if (isCarrier[op]) {
+                carriers[carrierCount++] = op;
+                carrierMask |= 1u << op;
+            }
+        }
+    }
+
+    // depths[mod][op] scales the modulation of op by mod. Depths of pairs that aren't connected are ignored.
+    template <typename Depths>
+    void setDepths(const Depths& depths) {
+        for (int op = 0; op < N; ++op) {
+            for (int i = 0; i < modulatorCounts[op]; ++i) {
+                modulationDepths[op][i] = depths[modulators[op][i]][op];
+            }
+        }
+    }
+
+    // Writes the operators that can affect the output to liveOrder, in evaluation order, and returns how many there
+    // are. An operator is live if it is not in the silent mask and it is a carrier or modulates a live operator, so
+    // a silent operator also kills the modulators that only reach the output through it.
+    int findLive(uint32_t silent, std::array<int, N>& liveOrder) const {
+        uint32_t live = 0;
+        uint32_t modulatesLive = 0;
+
+        // Reverse evaluation order visits every operator before its modulators, apart from those fed back around a
+        // cycle. They are found by repeating the pass until nothing changes.
+        for (;;) {
+            uint32_t previousLive = live;
+            for (int i = N - 1; i >= 0; --i) {
+                int op = order[i];
+                uint32_t bit = 1u << op;
+                if (!(silent & bit) && ((carrierMask | modulatesLive) & bit)) {
+                    live |= bit;
+                    for (int j = 0; j < modulatorCounts[op]; ++j) {
+                        modulatesLive |= 1u << modulators[op][j];
+                    }
+                }
+            }
+
+            if (!cyclic || live == previousLive) {
+                break;
+            }
+        }
+
+        int count = 0;
+        for (int i = 0; i < N; ++i) {
+            if (live & (1u << order[i])) {
+                liveOrder[count++] = order[i];
+            }
+        }
+        return count;
+    }
+
+    // Operators in evaluation order
+    std::array<int, N> order = {};
+
+    // modulators[op][0 .. modulatorCounts[op]) are the operators modulating op
+    std::array<std::array<int, N>, N> modulators = {};
+    std::array<int, N> modulatorCounts = {};
+    // modulationDepths[op][i] is the depth of modulators[op][i], 1 until setDepths() is called
+    std::array<std::array<float, N>, N> modulationDepths = {};
+    // fedBack[op][i] is true if modulators[op][i] comes later in the order, so op hears it around a cycle. Its
+    // modulation is scaled by the modulator's unmodulated frequency, as its modulated frequency already holds op's
+    // modulation and would grow around the loop without bound.
+    std::array<std::array<bool, N>, N> fedBack = {};
+
+    // Length of the longest chain of modulators leading into each operator. Operators on the same level don't
+    // depend on each other within a sample.
+    std::array<int, N> levels = {};
+    // True if any modulator is fed back from later in the order
+    bool cyclic = false;
+
+    // carriers[0 .. carrierCount) are the operators summed into the output
+    std::array<int, N> carriers = {};
+    int carrierCount = 0;
+    uint32_t carrierMask = 0;
+
+    // Library algorithm (see AlgorithmLibrary.hpp) the routing was loaded from, or -1. Set by the module after
+    // compiling, the engine renders it with that algorithm's unrolled kernel.
+    int libraryAlgorithm = -1;
+};
+
+// Groups operators into vectors of up to four for operator-parallel evaluation of a single voice. Each level of the
+// schedule is a wavefront of operators whose modulators are all on earlier levels, so a wavefront can be evaluated
+// as one SIMD vector across operators once the vectors before it are done.
+template <int N>
+struct WavefrontPlan {
+    static constexpr int LANES = 4;
+
+    // operators[0 .. count) are in evaluation order, e.g. the live operators of a block
+    void build(const RoutingSchedule<N>& schedule, const std::array<int, N>& operators, int count) {
+        vectorCount = 0;
+
+        int level = 0;
+        for (int placed = 0; placed < count; ++level) {
+            int vector = -1;
+            for (int i = 0; i < count; ++i) {
+                int op = operators[i];
+                if (schedule.levels[op] != level) {
+                    continue;
+                }
+
+                if (vector < 0 || laneCounts[vector] == LANES) {
+                    vector = vectorCount++;
+                    laneCounts[vector] = 0;
+                }
+                lanes[vector][laneCounts[vector]++] = op;
+                placed++;
+            }
+        }
+    }
+
+    // lanes[v][0 .. laneCounts[v]) are the operators in vector v
+    std::array<std::array<int, LANES>, N> lanes = {};
+    std::array<int, N> laneCounts = {};
+    int vectorCount = 0;
+};
+
+} // namespace ph
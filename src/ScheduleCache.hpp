@@ -0,0 +1,122 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include "RoutingSchedule.hpp"
+
+namespace ph {
+
+// The most recently used compiled schedules, keyed by routing, so flipping between a handful of algorithms (presets,
+// the algorithm library) doesn't re-sort and recompile the graph each time. Holds CAPACITY schedules and evicts the
+// least recently used. Nothing allocates and lookups are a linear scan, which is faster than hashing at this size.
+template <int N, int CAPACITY = 8>
+class ScheduleCache {
+    static_assert(N * (N - 1) + N <= 64, "The routing of N operators must fit a 64-bit key");
+
+public:
+    typedef uint64_t Key;
+
+    // Packs the N * (N - 1) off-diagonal bits of the adjacency matrix (30 for six operators) and the carrier mask
+    // above them. Everything RoutingSchedule::compile() and setCarriers() read is in the key.
+    template <typename Graph, typename Carriers>
+    static Key key(const Graph& graph, const Carriers& isCarrier) {
+        Key key = 0;
+        int bit = 0;
+        for (int src = 0; src < N; ++src) {
+            for (int dest = 0; dest < N; ++dest) {
+                if (src != dest) {
+                    key |= Key(graph.hasEdge(src, dest)) << bit++;
+                }
+            }
+        }
+
+        for (int op = 0; op < N; ++op) {
+            key |= Key(bool(isCarrier[op])) << (bit + op);
+        }
+        return key;
+    }
+
+    // Returns the schedule for key and marks it most recently used, or nullptr if it isn't cached. Counts towards
+    // the hit rate.
+    const RoutingSchedule<N>* find(Key key) {
+        Entry* entry = lookup(key);
+        if (!entry) {
+            misses++;
+            return nullptr;
+        }
+
+        hits++;
+        entry->lastUsed = ++clock;
+        return &entry->schedule;
+    }
+
+    bool contains(Key key) const {
+        for (const Entry& entry : entries) {
+            if (entry.valid && entry.key == key) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Adds a schedule as the most recently used, replacing the least recently used one if the cache is full
+    void insert(Key key, const RoutingSchedule<N>& schedule) {
+        Entry* entry = lookup(key);
+        if (!entry) {
+            entry = &entries[0];
+            for (Entry& candidate : entries) {
+                if (!candidate.valid) {
+                    entry = &candidate;
+                    break;
+                }
+                if (candidate.lastUsed < entry->lastUsed) {
+                    entry = &candidate;
+                }
+            }
+        }
+
+        entry->key = key;
+        entry->schedule = schedule;
+        entry->lastUsed = ++clock;
+        entry->valid = true;
+    }
+
+    void clear() {
+        for (Entry& entry : entries) {
+            entry.valid = false;
+        }
+        hits = 0;
+        misses = 0;
+    }
+
+    // Fraction of find() calls that returned a schedule, 0 before the first
+    float hitRate() const {
+        int lookups = hits + misses;
+        return lookups > 0 ? float(hits) / lookups : 0.f;
+    }
+
+    int hits = 0;
+    int misses = 0;
+
+private:
+    struct Entry {
+        Key key = 0;
+        RoutingSchedule<N> schedule;
+        uint32_t lastUsed = 0;
+        bool valid = false;
+    };
+
+    Entry* lookup(Key key) {
+        for (Entry& entry : entries) {
+            if (entry.valid && entry.key == key) {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    std::array<Entry, CAPACITY> entries;
+    uint32_t clock = 0;
+};
+
+} // namespace ph
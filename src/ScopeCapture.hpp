@@ -0,0 +1,71 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include "SpscRingBuffer.hpp"
+
+namespace ph {
+
+// Hands decimated scope points from the audio thread to a display. The audio thread pushes points into a lock-free
+// SPSC queue and the UI thread moves them into a history buffer that only it touches, so drawing never reads memory
+// the audio thread is writing.
+template <size_t SIZE>
+struct ScopeCapture {
+    // Audio thread. Points are dropped if the UI has stopped reading.
+    void push(float point) {
+        if (!queue.full()) {
+            queue.push(point);
+        }
+    }
+
+    // UI thread. Returns true if any new points arrived.
+    bool update() {
+        bool updated = false;
+        while (!queue.empty()) {
+            history[writeIndex] = queue.shift();
+            writeIndex = (writeIndex + 1) % SIZE;
+            updated = true;
+        }
+        return updated;
+    }
+
+    // UI thread. The i-th point of the history, oldest first.
+    float point(size_t i) const { return history[(writeIndex + i) % SIZE]; }
+
+    // Only call while the audio thread is not running, e.g. from Module::onReset()
+    void clear() {
+        queue.clear();
+        history.fill(0.f);
+        writeIndex = 0;
+    }
+
+    SpscRingBuffer<float, SIZE> queue;
+    std::array<float, SIZE> history = {};
+    size_t writeIndex = 0;
+};
+
+// Min/max of a scope history for each pixel column of a display, so a display draws COLUMNS points however long the
+// history is. Only needs recalculating when the history changes.
+template <size_t COLUMNS>
+struct ScopeEnvelope {
+    template <size_t SIZE>
+    void update(const ScopeCapture<SIZE>& scope) {
+        static_assert(SIZE >= COLUMNS, "Need at least one point per column");
+
+        minimums.fill(INFINITY);
+        maximums.fill(-INFINITY);
+
+        for (size_t i = 0; i < SIZE; ++i) {
+            size_t column = i * COLUMNS / SIZE;
+            float point = scope.point(i);
+            minimums[column] = std::min(minimums[column], point);
+            maximums[column] = std::max(maximums[column], point);
+        }
+    }
+
+    std::array<float, COLUMNS> minimums = {};
+    std::array<float, COLUMNS> maximums = {};
+};
+
+} // namespace ph
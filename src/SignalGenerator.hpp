@@ -1,10 +1,9 @@
 #ifndef PH_SIGNAL_GENERATOR_HPP
 #define PH_SIGNAL_GENERATOR_HPP
 
-#include <rack.hpp>
-#include "plugin.hpp"
-
-using namespace rack;
+#include "Dsp.hpp"
+#include "MorphWavetable.hpp"
+#include "SineBackend.hpp"
 
 namespace ph {
 
@@ -24,38 +23,94 @@ inline float normalisePhase(float phase) {
     return fmod(normalisedPhase, 1.f);
 }
 
-struct SpiderSignalGenerator {
-    float generate(float sampleTime, float freq, float wavePos, float phaseMod = 0) {
-        phase += freq * sampleTime;
+// Branchless sine -> triangle -> saw -> square -> sine morph for a phase in [0, 1], given sine = sin2pi(phase).
+// Every waveform is evaluated and weighted by a hat function of wavePos, so the
+// same code runs for a float or a float_4 with a different wavePos in each lane.
+template <typename T>
+T morphWave(T phase, T wavePos, T sine) {
+    T x = 4.f * wavePos;
+
+    T sineWeight = simd::fmax(1.f - x, 0.f) + simd::fmax(x - 3.f, 0.f);
+    T triangleWeight = simd::fmax(1.f - simd::fabs(x - 1.f), 0.f);
+    T sawWeight = simd::fmax(1.f - simd::fabs(x - 2.f), 0.f);
+    T squareWeight = simd::fmax(1.f - simd::fabs(x - 3.f), 0.f);
+
+    // With the phase wrapped to [0, 1] round() is just a comparison against 0.5
+    T upperHalf = simd::ifelse(phase >= 0.5f, T(1.f), T(0.f));
+
+    T triangleWave = 1.f - 4.f * simd::fabs(phase - 0.5f);
+    T sawWave = 2.f * (phase - upperHalf);
+    T squareWave = 1.f - 2.f * upperHalf;
+
+    return sineWeight * sine + triangleWeight * triangleWave + sawWeight * sawWave + squareWeight * squareWave;
+}
 
-        if (phase > 1.f)
-            phase -= 1.f;
-        if (phase < -1.f)
-            phase += 1.f;
-
-        float normalisedPM = normalisePhase(phase + (phaseMod / (2 * M_PI)));
-        float PM = phase + phaseMod / (2 * M_PI);
-        PM = fmod(PM, 1.f);
-        float blend = 0.f;
-
-        if (wavePos <= 0.25f) {
-            blend = crossfade(sin2pi(normalisedPM), triangle(phase), wavePos / 0.25f);
-        } else if (wavePos <= 0.5f) {
-            blend = crossfade(triangle(PM), saw(PM), (wavePos - 0.25f) / 0.25f);
-        } else if (wavePos <= 0.75f) {
-            blend = crossfade(saw(PM), square(PM), (wavePos - 0.5f) / 0.25f);
-        } else {
-            blend = crossfade(square(PM), sin2pi(normalisedPM), (wavePos - 0.75f) / 0.25f);
-        }
-
-        return blend;
+template <typename T, typename Sine = DefaultSineBackend>
+T morphWave(T phase, T wavePos) {
+    return morphWave(phase, wavePos, Sine::sin2pi(phase));
+}
+
+// T is float for a single voice or simd::float_4 for four polyphony channels at once. Sine is one of the backends
+// in SineBackend.hpp.
+template <typename T = float, typename Sine = DefaultSineBackend>
+struct TSpiderSignalGenerator {
+    T generate(float sampleTime, T freq, T wavePos, T phaseMod = 0.f) {
+        return morphWave<T, Sine>(advance(sampleTime, freq, phaseMod), wavePos);
+    }
+
+    // Same as generate() but reads the shared band-limited wavetable, using the mipmap level for freq
+    T generateBandLimited(float sampleTime, T freq, T wavePos, T phaseMod = 0.f) {
+        return morphWavetable.lookup(advance(sampleTime, freq, phaseMod), wavePos, freq * sampleTime);
     }
 
     void reset() { phase = 0.f; }
 
-    float phase = 0.f;
+    T phase = 0.f;
+
+private:
+    // Steps the phase and returns it with phaseMod (in radians) applied, wrapped to [0, 1)
+    T advance(float sampleTime, T freq, T phaseMod) {
+        phase += freq * sampleTime;
+        phase -= simd::floor(phase);
+
+        T modulatedPhase = phase + phaseMod / float(2 * M_PI);
+        modulatedPhase -= simd::floor(modulatedPhase);
+        return modulatedPhase;
+    }
 };
 
+typedef TSpiderSignalGenerator<> SpiderSignalGenerator;
+
+// Same interface as TSpiderSignalGenerator, but the phase is a 32-bit fixed point fraction of a cycle (see
+// FixedPhase) that wraps by overflowing. Phase modulation is added in the integer domain and the sine backend reads
+// its table index and interpolation fraction straight from the bits, so there is no float wrapping at all, and a
+// constant frequency advances by exactly the same step forever instead of drifting with float rounding.
+template <typename T = float, typename Sine = DefaultSineBackend>
+struct TFixedPhaseSignalGenerator {
+    typedef typename FixedPhase<T>::type Phase;
+
+    T generate(float sampleTime, T freq, T wavePos, T phaseMod = 0.f) {
+        Phase modulatedPhase = advance(sampleTime, freq, phaseMod);
+        return morphWave(fromFixedPhase(modulatedPhase), wavePos, Sine::sin2piFixed(modulatedPhase));
+    }
+
+    T generateBandLimited(float sampleTime, T freq, T wavePos, T phaseMod = 0.f) {
+        return morphWavetable.lookup(fromFixedPhase(advance(sampleTime, freq, phaseMod)), wavePos, freq * sampleTime);
+    }
+
+    void reset() { phase = Phase(0); }
+
+    Phase phase = Phase(0);
+
+private:
+    Phase advance(float sampleTime, T freq, T phaseMod) {
+        phase += toFixedPhase(freq * sampleTime);
+        return phase + toFixedPhase(phaseMod / float(2 * M_PI));
+    }
+};
+
+typedef TFixedPhaseSignalGenerator<> FixedPhaseSignalGenerator;
+
 } // namespace ph
 
 #endif // PH_SIGNAL_GENERATOR_HPP
@@ -0,0 +1,302 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include "Dsp.hpp"
+
+namespace ph {
+
+// Sine backends for sin2pi(x) = sin(2 * pi * x), chosen at compile time through the Sine template parameter of
+// morphWave() and the signal generators. Every backend wraps x itself, so any finite phase is valid, and has a
+// float and a simd::float_4 overload that give the same result on every lane. sin2piFixed() takes the phase as a
+// 32-bit fixed point fraction of a cycle instead (see FixedPhase).
+
+namespace detail {
+
+inline float wrapPhase(float x) {
+    return x - std::floor(x);
+}
+
+inline simd::float_4 wrapPhase(simd::float_4 x) {
+    return x - simd::floor(x);
+}
+
+constexpr int log2(int n) {
+    return (n > 1) ? 1 + log2(n / 2) : 0;
+}
+
+} // namespace detail
+
+// A phase held as a 32-bit fraction of a cycle, which wraps by overflowing. uint32_t for one voice and int32_4 for
+// four, where the sign bit is just the top bit of the phase and addition wraps the same way.
+template <typename T>
+struct FixedPhase;
+
+template <>
+struct FixedPhase<float> {
+    typedef uint32_t type;
+};
+
+template <>
+struct FixedPhase<simd::float_4> {
+    typedef simd::int32_4 type;
+};
+
+// Converts a phase in cycles to fixed point. r * 2^31 always fits an int32_t and the shift doubles it modulo 2^32,
+// the bit lost is far below float precision.
+inline uint32_t toFixedPhase(float cycles) {
+    float r = cycles - std::floor(cycles + 0.5f);
+    return uint32_t(int32_t(r * 2147483648.f)) << 1;
+}
+
+inline simd::int32_4 toFixedPhase(simd::float_4 cycles) {
+    simd::float_4 r = cycles - simd::floor(cycles + 0.5f);
+    return simd::int32_4(r * 2147483648.f) << 1;
+}
+
+// Top 24 bits of a fixed point phase, as many as a float holds exactly
+inline uint32_t phaseBits(uint32_t phase) {
+    return phase >> 8;
+}
+
+inline simd::int32_4 phaseBits(simd::int32_4 phase) {
+    return (phase >> 8) & simd::int32_4(0xffffff);
+}
+
+// Converts a fixed point phase to cycles in [0, 1)
+inline float fromFixedPhase(uint32_t phase) {
+    return float(phaseBits(phase)) * (1.f / (1 << 24));
+}
+
+inline simd::float_4 fromFixedPhase(simd::int32_4 phase) {
+    return simd::float_4(phaseBits(phase)) * (1.f / (1 << 24));
+}
+
+// Table of SIZE + GUARD entries holding sin(2 * pi * (i - 1) / SIZE), so an interpolator can read one entry before
+// and up to two after any index in [0, SIZE) without wrapping. Filled when the plugin is loaded.
+template <int SIZE>
+struct SineTable {
+    static_assert(SIZE >= 4 && SIZE <= (1 << 16) && (SIZE & (SIZE - 1)) == 0, "SIZE must be a power of two");
+    static constexpr int GUARD = 3;
+
+    // The top 24 bits of a fixed point phase (phaseBits()) split into a table index and an interpolation fraction
+    static constexpr int FRACTION_BITS = 24 - detail::log2(SIZE);
+    static constexpr int FRACTION_MASK = (1 << FRACTION_BITS) - 1;
+
+    SineTable() {
+        for (int i = 0; i < SIZE + GUARD; ++i) {
+            values[i] = std::sin(2.0 * M_PI * (i - 1) / SIZE);
+        }
+    }
+
+    // Sample i of the cycle, for i in [-1, SIZE + 1]
+    const float* at(int i) const { return &values[i + 1]; }
+
+    static uint32_t index(uint32_t bits) { return bits >> FRACTION_BITS; }
+    static simd::int32_4 index(simd::int32_4 bits) { return bits >> FRACTION_BITS; }
+
+    static float fraction(uint32_t bits) { return float(bits & FRACTION_MASK) * (1.f / (1 << FRACTION_BITS)); }
+    static simd::float_4 fraction(simd::int32_4 bits) {
+        return simd::float_4(bits & simd::int32_4(FRACTION_MASK)) * (1.f / (1 << FRACTION_BITS));
+    }
+
+    alignas(16) float values[SIZE + GUARD];
+};
+
+template <int SIZE>
+constexpr int SineTable<SIZE>::FRACTION_BITS;
+
+template <int SIZE>
+constexpr int SineTable<SIZE>::FRACTION_MASK;
+
+// Linear interpolation between SIZE samples of one cycle. Error is about (pi / SIZE)^2 / 2.
+template <int SIZE>
+struct LinearSineTable {
+    static float sin2pi(float x) {
+        x = detail::wrapPhase(x) * SIZE;
+        // x can round up to SIZE just below a whole cycle, the mask takes it back to 0
+        int i = int(x);
+        float f = x - i;
+        const float* p = table.at(i & (SIZE - 1));
+        return p[0] + f * (p[1] - p[0]);
+    }
+
+    static simd::float_4 sin2pi(simd::float_4 x) {
+        x = detail::wrapPhase(x) * SIZE;
+        simd::float_4 i = simd::floor(x);
+        simd::float_4 f = x - i;
+
+        // SSE has no gather so the table reads are done per lane
+        simd::float_4 a, b;
+        for (int lane = 0; lane < 4; ++lane) {
+            const float* p = table.at(int(i[lane]) & (SIZE - 1));
+            a[lane] = p[0];
+            b[lane] = p[1];
+        }
+        return a + f * (b - a);
+    }
+
+    static float sin2piFixed(uint32_t phase) {
+        uint32_t bits = phaseBits(phase);
+        float f = Table::fraction(bits);
+        const float* p = table.at(Table::index(bits));
+        return p[0] + f * (p[1] - p[0]);
+    }
+
+    static simd::float_4 sin2piFixed(simd::int32_4 phase) {
+        simd::int32_4 bits = phaseBits(phase);
+        simd::float_4 f = Table::fraction(bits);
+        simd::int32_4 i = Table::index(bits);
+
+        simd::float_4 a, b;
+        for (int lane = 0; lane < 4; ++lane) {
+            const float* p = table.at(i[lane]);
+            a[lane] = p[0];
+            b[lane] = p[1];
+        }
+        return a + f * (b - a);
+    }
+
+    typedef SineTable<SIZE> Table;
+    static const Table table;
+};
+
+template <int SIZE>
+const SineTable<SIZE> LinearSineTable<SIZE>::table;
+
+// Four point Lagrange (cubic) interpolation between SIZE samples of one cycle. Error is about (2 * pi / SIZE)^4 / 43,
+// so a 256 entry table is more accurate than a linear table of 4096 entries.
+template <int SIZE>
+struct CubicSineTable {
+    static float sin2pi(float x) {
+        x = detail::wrapPhase(x) * SIZE;
+        int i = int(x);
+        float f = x - i;
+        const float* p = table.at(i & (SIZE - 1));
+        return interpolate(p[-1], p[0], p[1], p[2], f);
+    }
+
+    static simd::float_4 sin2pi(simd::float_4 x) {
+        x = detail::wrapPhase(x) * SIZE;
+        simd::float_4 i = simd::floor(x);
+        simd::float_4 f = x - i;
+
+        simd::float_4 y0, y1, y2, y3;
+        for (int lane = 0; lane < 4; ++lane) {
+            const float* p = table.at(int(i[lane]) & (SIZE - 1));
+            y0[lane] = p[-1];
+            y1[lane] = p[0];
+            y2[lane] = p[1];
+            y3[lane] = p[2];
+        }
+        return interpolate(y0, y1, y2, y3, f);
+    }
+
+    static float sin2piFixed(uint32_t phase) {
+        uint32_t bits = phaseBits(phase);
+        float f = Table::fraction(bits);
+        const float* p = table.at(Table::index(bits));
+        return interpolate(p[-1], p[0], p[1], p[2], f);
+    }
+
+    static simd::float_4 sin2piFixed(simd::int32_4 phase) {
+        simd::int32_4 bits = phaseBits(phase);
+        simd::float_4 f = Table::fraction(bits);
+        simd::int32_4 i = Table::index(bits);
+
+        simd::float_4 y0, y1, y2, y3;
+        for (int lane = 0; lane < 4; ++lane) {
+            const float* p = table.at(i[lane]);
+            y0[lane] = p[-1];
+            y1[lane] = p[0];
+            y2[lane] = p[1];
+            y3[lane] = p[2];
+        }
+        return interpolate(y0, y1, y2, y3, f);
+    }
+
+    typedef SineTable<SIZE> Table;
+    static const Table table;
+
+private:
+    // Lagrange polynomial through (-1, y0), (0, y1), (1, y2), (2, y3) evaluated at f in [0, 1)
+    template <typename T>
+    static T interpolate(T y0, T y1, T y2, T y3, T f) {
+        T c1 = y2 - (1.f / 3.f) * y0 - 0.5f * y1 - (1.f / 6.f) * y3;
+        T c2 = 0.5f * (y0 + y2) - y1;
+        T c3 = (1.f / 6.f) * (y3 - y0) + 0.5f * (y1 - y2);
+        return y1 + f * (c1 + f * (c2 + f * c3));
+    }
+};
+
+template <int SIZE>
+const SineTable<SIZE> CubicSineTable<SIZE>::table;
+
+// Odd degree 9 minimax polynomial for sin(2 * pi * r) on r in [-1/4, 1/4], after folding the phase into that range.
+// No table and no per-lane reads, so the SIMD version is branchless. Error is below 1e-6, mostly float rounding.
+struct MinimaxSine {
+    static float sin2pi(float x) {
+        float r = x - std::floor(x + 0.5f);
+        if (r > 0.25f) {
+            r = 0.5f - r;
+        } else if (r < -0.25f) {
+            r = -0.5f - r;
+        }
+        return polynomial(r);
+    }
+
+    static simd::float_4 sin2pi(simd::float_4 x) {
+        simd::float_4 r = x - simd::floor(x + 0.5f);
+        r = simd::ifelse(r > 0.25f, 0.5f - r, r);
+        r = simd::ifelse(r < -0.25f, -0.5f - r, r);
+        return polynomial(r);
+    }
+
+    // Read as signed, a fixed point phase is already centred on zero so it only needs folding
+    static float sin2piFixed(uint32_t phase) {
+        float r = float(int32_t(phase)) * (1.f / 4294967296.f);
+        if (r > 0.25f) {
+            r = 0.5f - r;
+        } else if (r < -0.25f) {
+            r = -0.5f - r;
+        }
+        return polynomial(r);
+    }
+
+    static simd::float_4 sin2piFixed(simd::int32_4 phase) {
+        simd::float_4 r = simd::float_4(phase) * (1.f / 4294967296.f);
+        r = simd::ifelse(r > 0.25f, 0.5f - r, r);
+        r = simd::ifelse(r < -0.25f, -0.5f - r, r);
+        return polynomial(r);
+    }
+
+private:
+    template <typename T>
+    static T polynomial(T r) {
+        T r2 = r * r;
+        T p = 3.9536706078e+01f;
+        p = p * r2 - 7.6549782295e+01f;
+        p = p * r2 + 8.1601004073e+01f;
+        p = p * r2 - 4.1341655031e+01f;
+        p = p * r2 + 6.2831851601e+00f;
+        return p * r;
+    }
+};
+
+// The backend used by sin2pi() and the signal generators. The polynomial is as accurate as a cubic table and, with no
+// per-lane table reads, several times faster on float_4. Builds can pick another with -DPH_SINE_BACKEND=...
+#ifdef PH_SINE_BACKEND
+typedef PH_SINE_BACKEND DefaultSineBackend;
+#else
+typedef MinimaxSine DefaultSineBackend;
+#endif
+
+inline float sin2pi(float x) {
+    return DefaultSineBackend::sin2pi(x);
+}
+
+inline simd::float_4 sin2pi(simd::float_4 x) {
+    return DefaultSineBackend::sin2pi(x);
+}
+
+} // namespace ph
@@ -1,17 +1,29 @@
 #include "plugin.hpp"
-#include "DirectedGraph.hpp"
+#include "AlgorithmLibrary.hpp"
+#include "FixedDirectedGraph.hpp"
+#include "GraphJson.hpp"
+#include "RoutingSchedule.hpp"
+#include "ScheduleCache.hpp"
+#include "SpiderEngine.hpp"
 #include "Components.hpp"
 
-#include "SignalGenerator.hpp"
-
 #include <array>
 
 namespace { // anonymous
 
-constexpr int OPERATOR_COUNT = 6;
-constexpr int CONNECTION_COUNT = OPERATOR_COUNT * OPERATOR_COUNT;
-constexpr int BUFFER_SIZE = 512;
-constexpr int MAX_CHANNEL_COUNT = 16;
+constexpr int CONNECTION_COUNT = ph::OPERATOR_COUNT * ph::OPERATOR_COUNT;
+constexpr int SCOPE_COLUMNS = 48; // one per pixel of the display's inner width
+
+// Modulation depth of a connection, as a multiple of the default modulation index
+constexpr float MAX_MODULATION_DEPTH = 2.f;
+const std::array<int, 5> CONTROL_DIVISIONS = {4, 8, 16, 32, 64};
+
+const std::array<int, 4> OVERSAMPLING_FACTORS = {1, 2, 4, 8};
+
+#ifdef PH_TRACE
+// Written to Rack's user folder
+const char* const TRACE_FILE_NAME = "PostHuman-Spider-trace.json";
+#endif
 
 } // anonymous namespace
 
@@ -45,7 +57,11 @@ struct Spider : Module {
 
     Spider() {
         configParameters();
+        for (auto& depths : modulationDepths) {
+            depths.fill(1.f);
+        }
         setConnectionLights();
+        updateSchedule();
     }
 
     void configParameters() {
@@ -77,30 +93,19 @@ struct Spider : Module {
         }
     }
 
-    void processEdit(float sampleTime) {
-        if (cycleDetected) {
-            if (cycleFlashTimer.process(sampleTime) > 0.45f) {
-                cycleDetected = false;
-            }
-        }
+    // Handles the operator buttons. This runs on the UI thread from SpiderWidget::step() so that graph edits,
+    // tooltip strings and schedule compilation never happen on the audio thread.
+    void processEdit(float deltaTime) {
+        PH_PERF_SCOPE(engine.perf.edit);
+        PH_PERF_ALLOCATIONS(engine.perf.editAllocations);
+        PH_TRACE_SCOPE("edit");
 
-        bool cycleDetectedLow = cycleDetectedTrigger.process(!cycleDetected);
+        if (schedulePending) {
+            sendSchedule();
+        }
 
         for (int i = 0; i < OPERATOR_COUNT; ++i) {
-            if (cycleDetectedLow) {
-                getLight(SELECT_LIGHTS + i * 3 + 2).setBrightness(0.f);
-                setCarrierLights();
-            }
-
-            if (cycleDetected) {
-                getLight(SELECT_LIGHTS + i * 3).setBrightness(0.0f);
-                getLight(SELECT_LIGHTS + i * 3 + 1).setBrightness(0.0f);
-
-                float flashBrightness = fmod(cycleFlashTimer.getTime(), 0.15f) > 0.075f ? 1.0f : 0.0f;
-                getLight(SELECT_LIGHTS + i * 3 + 2).setBrightness(flashBrightness);
-            }
-
-            getLight(SELECT_LIGHTS + i * 3 + 1).setBrightnessSmooth(selectedOperator == i, sampleTime);
+            getLight(SELECT_LIGHTS + i * 3 + 1).setBrightnessSmooth(selectedOperator == i, deltaTime);
 
             auto& trigger = operatorTriggers[i];
             bool selectTriggered = trigger.process(getParam(SELECT_PARAMS + i).getValue());
@@ -108,30 +113,19 @@ struct Spider : Module {
             if (selectTriggered) {
                 if (selectedOperator == i) {
                     carriers[i] = !carriers[i];
+                    libraryAlgorithm = -1;
                     getLight(SELECT_LIGHTS + i * 3).setBrightness(carriers[i] ? 1.0f : 0.0f);
+                    publishSchedule();
                     updateTooltips(i, false);
                     selectedOperator = -1;
 
                 } else if (selectedOperator > -1) {
-                    auto result = algorithmGraph.toggleEdge(selectedOperator, i);
-
-                    if (result == ToggleEdgeResult::CYCLE) {
-                        updateTooltips(i, false);
-                        selectedOperator = -1;
-                        cycleDetected = true;
-                        cycleFlashTimer.reset();
-                        return;
-                    }
+                    // Every edge is accepted, one against an existing edge makes a feedback loop
+                    bool added = algorithmGraph.toggleEdge(selectedOperator, i);
 
-                    if (result == ToggleEdgeResult::ADDED) {
-                        getLight(CONNECTION_LIGHTS + OPERATOR_COUNT * selectedOperator + i).setBrightness(1.0f);
-                    } else if (result == ToggleEdgeResult::SWAPPED) {
-                        getLight(CONNECTION_LIGHTS + OPERATOR_COUNT * i + selectedOperator).setBrightness(0.0f);
-                        getLight(CONNECTION_LIGHTS + OPERATOR_COUNT * selectedOperator + i).setBrightness(1.0f);
-                    } else if (result == ToggleEdgeResult::REMOVED) {
-                        getLight(CONNECTION_LIGHTS + OPERATOR_COUNT * selectedOperator + i).setBrightness(0.0f);
-                    }
-                    topologicalOrder = algorithmGraph.topologicalSort();
+                    libraryAlgorithm = -1;
+                    getLight(CONNECTION_LIGHTS + OPERATOR_COUNT * selectedOperator + i).setBrightness(added ? 1.f : 0.f);
+                    updateSchedule();
 
                     updateTooltips(selectedOperator, false);
                     selectedOperator = -1;
@@ -169,145 +163,211 @@ struct Spider : Module {
         }
     }
 
-    void reset() {
-        for (int i = 0; i < OPERATOR_COUNT; ++i) {
-            reset(i);
-        }
-    }
-
-    void reset(int op) {
-        for (int c = 0; c < MAX_CHANNEL_COUNT; c++) {
-            signalGenerators[op * MAX_CHANNEL_COUNT + c].reset();
-        }
-
-        bufferIndex[op] = 0;
-        frameIndex[op] = 0;
-        std::fill(pointBuffer[op].begin(), pointBuffer[op].end(), 0.f);
-    }
-
     void process(const ProcessArgs& args) override {
-        int newChannels = std::max(1, getInput(VOCT_INPUT).getChannels());
+#ifdef PH_PERF_COUNTERS
+        engine.perf.beginFrame();
+#endif
+        PH_PERF_SCOPE(engine.perf.process);
+        PH_PERF_ALLOCATIONS(engine.perf.audioAllocations);
+#ifdef PH_TRACE
+        // Rack can move the module between its engine threads
+        traceThreadName("engine");
+#endif
 
-        if (channels != newChannels) {
-            channels = newChannels;
-            freqs.resize(OPERATOR_COUNT * channels);
-            outs.resize(OPERATOR_COUNT * channels);
-            oldOuts.resize(OPERATOR_COUNT * channels);
-        }
+        engine.channels = std::max(1, getInput(VOCT_INPUT).getChannels());
 
-        for (int op = 0; op < OPERATOR_COUNT; ++op) {
-            for (int c = 0; c < channels; c++) {
-                float freqParam = getParam(FREQ_PARAM).getValue() / 12.f;
-                float pitch = freqParam + getInput(VOCT_INPUT).getPolyVoltage(c);
-                freqs[op * channels + c] = dsp::FREQ_C4 * dsp::exp2_taylor5(pitch);
+        receiveSchedule();
+        if (!getOutput(AUDIO_OUTPUT).isConnected() || engine.schedule.carrierCount == 0) {
+            if (!engine.idle) {
+                sleep();
             }
+            getOutput(AUDIO_OUTPUT).setChannels(engine.channels);
+            return;
         }
 
-        processEdit(args.sampleTime);
-        processOperators(args);
+        if (engine.idle) {
+            engine.wake(args.sampleRate);
+        }
 
-        getOutput(AUDIO_OUTPUT).setChannels(channels);
+        for (int c = 0; c < engine.channels; c += 4) {
+            getInput(VOCT_INPUT).getPolyVoltageSimd<simd::float_4>(c).store(&pitchFrame[c]);
+        }
 
-        for (int c = 0; c < channels; c++) {
-            float output = 0.f;
+        // Rack hands us one frame at a time so the module renders blocks of one frame
+        renderBlock(args, 1, pitchFrame.data(), outputFrame.data());
 
-            for (int op = 0; op < OPERATOR_COUNT; ++op) {
-                if (carriers[op]) {
-                    output += outs[op * channels + c];
-                }
-            }
+        getOutput(AUDIO_OUTPUT).setChannels(engine.channels);
 
-            if (output > 1.f) {
-                output = 1.f;
-            } else if (output < -1.f) {
-                output = -1.f;
-            }
-
-            getOutput(AUDIO_OUTPUT).setVoltage(5.f * output, c);
+        for (int c = 0; c < engine.channels; c += 4) {
+            simd::float_4 output = simd::float_4::load(&outputFrame[c]);
+            getOutput(AUDIO_OUTPUT).setVoltageSimd(5.f * output, c);
         }
     }
 
-    void processOperators(const ProcessArgs& args) {
-        for (int i = 0; i < OPERATOR_COUNT; ++i) {
-            int op = topologicalOrder[i];
-            processOperator(op, args);
+    // Nothing can be heard, so the engine sleeps until the output is patched and there is a carrier again. Edits
+    // and lights keep running on the UI thread.
+    void sleep() {
+        engine.sleep();
+
+        for (int c = 0; c < MAX_CHANNEL_COUNT; ++c) {
+            getOutput(AUDIO_OUTPUT).setVoltage(0.f, c);
         }
     }
 
-    void processOperator(int op, const ProcessArgs& args) {
-        float levelParam = getParam(LEVEL_PARAMS + op).getValue();
-        float levelCv = getParam(LEVEL_CV_PARAMS + op).getValue();
-        float levelInput = getInput(LEVEL_INPUTS + op).getVoltage() / 10.f;
-
-        float level = levelParam + (levelInput * levelCv);
+    // Renders a block with the engine, see SpiderEngine::renderBlock(). The params and CV inputs are only read
+    // when the engine is going to use them. A new schedule is picked up by receiveSchedule() at the start of the
+    // block, not here.
+    void renderBlock(const ProcessArgs& args, int frames, const float* pitch, float* output) {
+        if (engine.controlsDue()) {
+            readParams();
+        }
 
-        level = clamp(level, 0.f, 1.f);
+        RenderArgs renderArgs;
+        renderArgs.sampleRate = args.sampleRate;
+        renderArgs.sampleTime = args.sampleTime;
+        engine.renderBlock(renderArgs, engineParams, frames, pitch, output);
+    }
 
-        // if (level == 0.f) {
-        // TODO: this needs to set outs[op] to 0 for all channels
-        // if it's going to be gbrought back
-        //     reset(op);
-        //     return;
-        // }
+    void readParams() {
+        engineParams.frequency = getParam(FREQ_PARAM).getValue();
 
-        float pitchShiftParam = getParam(PITCH_PARAMS + op).getValue();
-        float pitchShiftCv = getParam(PITCH_CV_PARAMS + op).getValue();
-        float pitchShiftInput = getInput(PITCH_INPUTS + op).getVoltage() / 10.f;
+        for (int op = 0; op < OPERATOR_COUNT; ++op) {
+            OperatorParams& opParams = engineParams.operators[op];
+            opParams.level = getParam(LEVEL_PARAMS + op).getValue();
+            opParams.levelCv = getParam(LEVEL_CV_PARAMS + op).getValue();
+            opParams.levelInput = getInput(LEVEL_INPUTS + op).getVoltage();
+            opParams.pitch = getParam(PITCH_PARAMS + op).getValue();
+            opParams.pitchCv = getParam(PITCH_CV_PARAMS + op).getValue();
+            opParams.pitchInput = getInput(PITCH_INPUTS + op).getVoltage();
+            opParams.wave = getParam(WAVE_PARAMS + op).getValue();
+            opParams.waveCv = getParam(WAVE_CV_PARAMS + op).getValue();
+            opParams.waveInput = getInput(WAVE_INPUTS + op).getVoltage();
+            opParams.feedback = getParam(FEEDBACK_PARAMS + op).getValue();
+        }
+    }
 
-        float octaveShift = pitchShiftParam / 12.0f;
+    // Call after editing algorithmGraph to re-sort it and publish the new schedule. A routing that is still cached
+    // keeps the order it was compiled with and isn't sorted again.
+    void updateSchedule() {
+        if (!scheduleCache.contains(ScheduleCache<OPERATOR_COUNT>::key(algorithmGraph, carriers))) {
+            algorithmGraph.topologicalSort(topologicalOrder);
+        }
+        publishSchedule();
+    }
 
-        float wavePosParam = getParam(WAVE_PARAMS + op).getValue();
-        float wavePosCv = getParam(WAVE_CV_PARAMS + op).getValue();
-        float wavePosInput = getInput(WAVE_INPUTS + op).getVoltage() / 10.f;
-        float wavePos = wavePosParam + (wavePosCv * wavePosInput);
-        wavePos = clamp(wavePos, 0.f, 1.f);
+    // Replaces the graph and carriers with a library algorithm. Runs on the UI thread like processEdit().
+    void loadAlgorithm(int index) {
+        loadLibraryAlgorithm(index, algorithmGraph, carriers);
+        libraryAlgorithm = index;
 
-        float feedbackParam = getParam(FEEDBACK_PARAMS + op).getValue();
+        if (selectedOperator > -1) {
+            updateTooltips(selectedOperator, false);
+            selectedOperator = -1;
+        }
 
-        const auto& modulators = algorithmGraph.getAdjacentVerticesRev(op);
+        clearConnectionLights();
+        setConnectionLights();
+        updateSchedule();
+    }
 
-        for (int c = 0; c < channels; c++) {
-            float& freq = freqs[op * channels + c];
+    // Sets how strongly mod modulates op. Runs on the UI thread, only the depths of the published schedule change.
+    void setModulationDepth(int mod, int op, float depth) {
+        modulationDepths[mod][op] = clamp(depth, 0.f, MAX_MODULATION_DEPTH);
+        pendingSchedule.setDepths(modulationDepths);
+        sendSchedule();
+    }
 
-            freq *= dsp::exp2_taylor5(octaveShift);                    // +- 12 semitones coarse pitch
-            freq *= dsp::exp2_taylor5(pitchShiftInput * pitchShiftCv); // +-12 semitones pitch shift
+    // Compiles the graph and carriers, or takes their schedule from the cache, and hands it to the audio thread.
+    // Depths aren't part of the cache key, they are applied to whichever schedule is used.
+    void publishSchedule() {
+        PH_TRACE_SCOPE("schedule rebuild");
+
+        ScheduleCache<OPERATOR_COUNT>::Key key = ScheduleCache<OPERATOR_COUNT>::key(algorithmGraph, carriers);
+        const RoutingSchedule<OPERATOR_COUNT>* cached = scheduleCache.find(key);
+
+        if (cached) {
+            pendingSchedule = *cached;
+            topologicalOrder = cached->order;
+        } else {
+            pendingSchedule.compile(algorithmGraph, topologicalOrder);
+            pendingSchedule.setCarriers(carriers);
+            scheduleCache.insert(key, pendingSchedule);
+        }
 
-            // resize buffer whenever samplesPerCycle changes
-            int samplesPerCycle = (args.sampleRate / freq);
+        // A hand-edited routing can match a library algorithm's, but only a loaded one is marked for its kernel
+        pendingSchedule.libraryAlgorithm = libraryAlgorithm;
+        pendingSchedule.setDepths(modulationDepths);
+        sendSchedule();
+    }
 
-            for (int mod : modulators) {
-                float modFreq = freqs[mod * channels + c];
-                freq += 5.f * modFreq * outs[mod * channels + c];
-            }
+    // If the queue is full (the engine isn't running) the schedule is sent again on the next edit step
+    void sendSchedule() {
+        if (scheduleQueue.full()) {
+            schedulePending = true;
+            return;
+        }
 
-            float old0 = outs[op * channels + c];
-            float old1 = oldOuts[op * channels + c];
+#ifdef PH_PERF_COUNTERS
+        engine.perf.publishTicks.store(perfTicks(), std::memory_order_relaxed);
+#endif
+        scheduleQueue.push(pendingSchedule);
+        schedulePending = false;
+    }
 
-            float avgOldSample = (old0 + old1) / 2;
+    // Audio thread side of publishSchedule(), only the latest schedule is kept
+    void receiveSchedule() {
+        if (scheduleQueue.empty()) {
+            return;
+        }
 
-            float feedback = 5.f * feedbackParam * avgOldSample;
+        while (!scheduleQueue.empty()) {
+            engine.setSchedule(scheduleQueue.shift());
+        }
 
-            outs[op * channels + c] =
-                level * signalGenerators[op * MAX_CHANNEL_COUNT + c].generate(args.sampleTime, freq, wavePos, feedback);
+#ifdef PH_PERF_COUNTERS
+        engine.perf.scheduleLatency.add(perfTicks() - engine.perf.publishTicks.load(std::memory_order_relaxed));
+#endif
+    }
 
-            if (c == 0) {
-                if (bufferIndex[op] < BUFFER_SIZE) { // Capture only one period
-                    if (++frameIndex[op] >= samplesPerCycle) {
-                        frameIndex[op] = 0;
+#ifdef PH_PERF_COUNTERS
+    // The Performance menu's counters, times in microseconds
+    json_t* perfToJson() const {
+        const SpiderPerf<OPERATOR_COUNT>& perf = engine.perf;
+        double usPerTick = 1e-3 / perf.clock.ticksPerNs();
+
+        auto counterToJson = [=](const PerfCounter& counter) {
+            PerfCounter::Snapshot snapshot = counter.snapshot();
+            json_t* counterJ = json_object();
+            json_object_set_new(counterJ, "calls", json_integer(snapshot.calls));
+            json_object_set_new(counterJ, "meanTicks", json_real(snapshot.meanTicks()));
+            json_object_set_new(counterJ, "meanUs", json_real(snapshot.meanTicks() * usPerTick));
+            json_object_set_new(counterJ, "maxUs", json_real(snapshot.maxTicks * usPerTick));
+            return counterJ;
+        };
 
-                        pointBuffer[op][bufferIndex[op]] = outs[op * channels + c];
-                        bufferIndex[op]++;
-                    }
-                } else {
-                    bufferIndex[op] = 0;
-                }
-            }
+        json_t* rootJ = json_object();
+        json_object_set_new(rootJ, "ticksPerNs", json_real(perf.clock.ticksPerNs()));
+        json_object_set_new(rootJ, "channels", json_integer(engine.channels));
+        json_object_set_new(rootJ, "process", counterToJson(perf.process));
+        json_object_set_new(rootJ, "processOperators", counterToJson(perf.processOperators));
+
+        json_t* operatorsJ = json_array();
+        for (const PerfCounter& counter : perf.operators) {
+            json_array_append_new(operatorsJ, counterToJson(counter));
         }
+        json_object_set_new(rootJ, "operators", operatorsJ);
+
+        json_object_set_new(rootJ, "edit", counterToJson(perf.edit));
+        json_object_set_new(rootJ, "scheduleLatency", counterToJson(perf.scheduleLatency));
+        json_object_set_new(rootJ, "audioAllocations", json_integer(perf.audioAllocations.load()));
+        json_object_set_new(rootJ, "editAllocations", json_integer(perf.editAllocations.load()));
+        return rootJ;
     }
+#endif
 
     json_t* dataToJson() override {
         json_t* rootJ = json_object();
-        json_object_set_new(rootJ, "algorithm", algorithmGraph.toJson());
+        json_object_set_new(rootJ, "algorithm", graphToJson(algorithmGraph));
 
         json_t* topologicalOrderJ = json_array();
         for (int i : topologicalOrder) {
@@ -321,12 +381,32 @@ struct Spider : Module {
         }
         json_object_set_new(rootJ, "carriers", carriersJ);
 
+        if (libraryAlgorithm >= 0) {
+            json_object_set_new(rootJ, "libraryAlgorithm", json_integer(libraryAlgorithm));
+        }
+
+        // Indexed [modulator][operator]
+        json_t* modulationDepthsJ = json_array();
+        for (const auto& depths : modulationDepths) {
+            json_t* depthsJ = json_array();
+            for (float depth : depths) {
+                json_array_append_new(depthsJ, json_real(depth));
+            }
+            json_array_append_new(modulationDepthsJ, depthsJ);
+        }
+        json_object_set_new(rootJ, "modulationDepths", modulationDepthsJ);
+
+        json_object_set_new(rootJ, "controlDivision", json_integer(engine.controlDivision));
+        json_object_set_new(rootJ, "audioRateCv", json_boolean(engine.audioRateCv));
+        json_object_set_new(rootJ, "oversampling", json_integer(engine.oversampling));
+        json_object_set_new(rootJ, "bandLimited", json_boolean(engine.bandLimited));
+
         return rootJ;
     }
 
     void dataFromJson(json_t* rootJ) override {
         json_t* algorithmJ = json_object_get(rootJ, "algorithm");
-        algorithmGraph.fromJson(algorithmJ);
+        graphFromJson(algorithmGraph, algorithmJ);
 
         json_t* topologicalOrderJ = json_object_get(rootJ, "topologicalOrder");
         for (int i = 0; i < OPERATOR_COUNT; ++i) {
@@ -338,14 +418,63 @@ struct Spider : Module {
             carriers[i] = json_boolean_value(json_array_get(carriersJ, i));
         }
 
+        // The routing is rebuilt from the library rather than trusting the saved graph to match it
+        json_t* libraryAlgorithmJ = json_object_get(rootJ, "libraryAlgorithm");
+        int index = libraryAlgorithmJ ? json_integer_value(libraryAlgorithmJ) : -1;
+        if (index >= 0 && index < LIBRARY_ALGORITHM_COUNT) {
+            loadLibraryAlgorithm(index, algorithmGraph, carriers);
+            algorithmGraph.topologicalSort(topologicalOrder);
+            libraryAlgorithm = index;
+        } else {
+            libraryAlgorithm = -1;
+        }
+
+        // Patches from before depths were editable modulate everything at depth 1
+        json_t* modulationDepthsJ = json_object_get(rootJ, "modulationDepths");
+        for (int mod = 0; mod < OPERATOR_COUNT; ++mod) {
+            json_t* depthsJ = json_array_get(modulationDepthsJ, mod);
+            for (int op = 0; op < OPERATOR_COUNT; ++op) {
+                json_t* depthJ = json_array_get(depthsJ, op);
+                float depth = depthJ ? json_number_value(depthJ) : 1.f;
+                modulationDepths[mod][op] = clamp(depth, 0.f, MAX_MODULATION_DEPTH);
+            }
+        }
+        publishSchedule();
+
+        json_t* controlDivisionJ = json_object_get(rootJ, "controlDivision");
+        if (controlDivisionJ) {
+            engine.controlDivision = std::max(1, (int)json_integer_value(controlDivisionJ));
+        }
+
+        json_t* audioRateCvJ = json_object_get(rootJ, "audioRateCv");
+        if (audioRateCvJ) {
+            engine.audioRateCv = json_boolean_value(audioRateCvJ);
+        }
+
+        json_t* bandLimitedJ = json_object_get(rootJ, "bandLimited");
+        if (bandLimitedJ) {
+            engine.bandLimited = json_boolean_value(bandLimitedJ);
+        }
+
+        json_t* oversamplingJ = json_object_get(rootJ, "oversampling");
+        if (oversamplingJ) {
+            int factor = json_integer_value(oversamplingJ);
+            if (std::find(OVERSAMPLING_FACTORS.begin(), OVERSAMPLING_FACTORS.end(), factor) !=
+                OVERSAMPLING_FACTORS.end()) {
+                engine.oversampling = factor;
+            }
+        }
+        engine.snapControls = true;
+
         setConnectionLights();
     }
 
     void setConnectionLights() {
-        for (size_t i = 0; i < algorithmGraph.adjList.size(); ++i) {
-            for (size_t j = 0; j < algorithmGraph.adjList[i].size(); ++j) {
-                int lightId = CONNECTION_LIGHTS + i * OPERATOR_COUNT + algorithmGraph.adjList[i][j];
-                getLight(lightId).setBrightness(1.0f);
+        for (int i = 0; i < OPERATOR_COUNT; ++i) {
+            for (int j = 0; j < OPERATOR_COUNT; ++j) {
+                if (algorithmGraph.hasEdge(i, j)) {
+                    getLight(CONNECTION_LIGHTS + i * OPERATOR_COUNT + j).setBrightness(1.0f);
+                }
             }
         }
 
@@ -377,10 +506,15 @@ struct Spider : Module {
 
         clearConnectionLights();
         algorithmGraph.clear();
-        topologicalOrder = {0, 1, 2, 3, 4, 5};
+        libraryAlgorithm = -1;
+        for (auto& depths : modulationDepths) {
+            depths.fill(1.f);
+        }
+        updateSchedule();
         updateTooltips(selectedOperator, false);
         selectedOperator = -1;
-        reset();
+        engine.reset();
+        engine.snapControls = true;
 
         Module::onReset();
     }
@@ -389,47 +523,89 @@ struct Spider : Module {
         algorithmGraph.clear();
         clearConnectionLights();
 
+        // Operators only modulate those after them in a shuffled order, so random patches have no feedback loops.
+        // Loops are left for the player to add.
+        std::array<int, OPERATOR_COUNT> shuffled;
+        for (int i = 0; i < OPERATOR_COUNT; ++i) {
+            shuffled[i] = i;
+        }
+        for (int i = OPERATOR_COUNT - 1; i > 0; --i) {
+            std::swap(shuffled[i], shuffled[random::u32() % (i + 1)]);
+        }
+
         for (int i = 0; i < OPERATOR_COUNT; ++i) {
             carriers[i] = random::uniform() > 0.5f;
 
-            for (int j = 0; j < OPERATOR_COUNT; ++j) {
+            for (int j = i + 1; j < OPERATOR_COUNT; ++j) {
                 if (random::uniform() > 0.75f) {
-                    algorithmGraph.addEdge(i, j);
+                    algorithmGraph.addEdge(shuffled[i], shuffled[j]);
                 }
             }
         }
 
-        topologicalOrder = algorithmGraph.topologicalSort();
+        libraryAlgorithm = -1;
+        updateSchedule();
         setConnectionLights();
 
         Module::onRandomize();
     }
 
-    std::array<SpiderSignalGenerator, OPERATOR_COUNT * 16> signalGenerators;
-    std::vector<float> freqs;
-    std::vector<float> outs;
-
-    // Store previous samples to calculate operator feedback
-    std::vector<float> oldOuts;
-    int channels = -1;
+    SpiderEngine engine;
+    // Filled in from the params and CV inputs whenever the engine is about to read them
+    SpiderParams engineParams = {};
 
-    // only one channel is needed for the buffers
-    // point buffer for the scope displays
-    std::array<int, OPERATOR_COUNT> bufferIndex = {0, 0, 0, 0, 0, 0};
-    std::array<int, OPERATOR_COUNT> frameIndex = {0, 0, 0, 0, 0, 0};
-    std::array<std::array<float, BUFFER_SIZE>, OPERATOR_COUNT> pointBuffer = {};
+    // Single frame buffers for process()
+    alignas(16) std::array<float, MAX_CHANNEL_COUNT> pitchFrame = {};
+    alignas(16) std::array<float, MAX_CHANNEL_COUNT> outputFrame = {};
 
     std::array<float, OPERATOR_COUNT> lastWavePos;
+    // Edited on the UI thread, the audio thread only reads schedule.carriers
     std::array<bool, OPERATOR_COUNT> carriers = {};
     std::array<dsp::BooleanTrigger, OPERATOR_COUNT> operatorTriggers;
-    std::vector<int> topologicalOrder = {0, 1, 2, 3, 4, 5};
-    DirectedGraph<int> algorithmGraph{OPERATOR_COUNT};
+    std::array<int, OPERATOR_COUNT> topologicalOrder = {0, 1, 2, 3, 4, 5};
+    FixedDirectedGraph<OPERATOR_COUNT> algorithmGraph;
+    // Library algorithm the graph and carriers were loaded from, -1 once they are edited by hand
+    int libraryAlgorithm = -1;
+    // modulationDepths[mod][op] scales the modulation index of the connection from mod to op. Kept for pairs that
+    // aren't connected, so removing and restoring a connection keeps its depth.
+    std::array<std::array<float, OPERATOR_COUNT>, OPERATOR_COUNT> modulationDepths;
+
+    // The UI thread compiles pendingSchedule and sends it through scheduleQueue to engine.schedule
+    RoutingSchedule<OPERATOR_COUNT> pendingSchedule;
+    dsp::RingBuffer<RoutingSchedule<OPERATOR_COUNT>, 8> scheduleQueue;
+    bool schedulePending = false;
+    // UI thread only
+    ScheduleCache<OPERATOR_COUNT> scheduleCache;
 
     int selectedOperator = -1;
-    bool cycleDetected = false;
-    rack::dsp::TTimer<float> cycleFlashTimer;
+};
 
-    dsp::BooleanTrigger cycleDetectedTrigger;
+// Context menu slider for the modulation depth of one connection
+struct ModulationDepthQuantity : Quantity {
+    ModulationDepthQuantity(Spider* module, int mod, int op) : module(module), mod(mod), op(op) {}
+
+    void setValue(float value) override { module->setModulationDepth(mod, op, value); }
+    float getValue() override { return module->modulationDepths[mod][op]; }
+    float getMinValue() override { return 0.f; }
+    float getMaxValue() override { return MAX_MODULATION_DEPTH; }
+    float getDefaultValue() override { return 1.f; }
+    float getDisplayValue() override { return getValue() * 100.f; }
+    void setDisplayValue(float displayValue) override { setValue(displayValue / 100.f); }
+    std::string getLabel() override { return "Operator " + std::to_string(mod + 1) + " to " + std::to_string(op + 1); }
+    std::string getUnit() override { return "%"; }
+
+    Spider* module;
+    int mod;
+    int op;
+};
+
+struct ModulationDepthSlider : ui::Slider {
+    ModulationDepthSlider(Spider* module, int mod, int op) {
+        quantity = new ModulationDepthQuantity(module, mod, op);
+        box.size.x = 200.f;
+    }
+
+    ~ModulationDepthSlider() { delete quantity; }
 };
 
 struct SpiderDisplay : public OpaqueWidget {
@@ -437,6 +613,14 @@ struct SpiderDisplay : public OpaqueWidget {
 
     SpiderDisplay() { this->box.size = Vec(56, 28); }
 
+    void step() override {
+        if (module && module->engine.scopes[op].update()) {
+            envelope.update(module->engine.scopes[op]);
+        }
+
+        OpaqueWidget::step();
+    }
+
     void drawLayer(const DrawArgs& args, int layer) override {
         if (layer != 1)
             return;
@@ -444,6 +628,8 @@ struct SpiderDisplay : public OpaqueWidget {
         if (!module)
             return;
 
+        module->engine.scopesRequested = true;
+
         nvgStrokeWidth(args.vg, 0.5f);
         nvgScissor(args.vg, RECT_ARGS(args.clipBox));
 
@@ -471,31 +657,44 @@ struct SpiderDisplay : public OpaqueWidget {
 
         nvgScissor(args.vg, RECT_ARGS(innerClipBox));
 
+        // Band between each column's min and max, along the maximums then back along the minimums
         nvgBeginPath(args.vg);
 
-        for (size_t i = 0; i < BUFFER_SIZE; ++i) {
-            float t = float(i) / (BUFFER_SIZE - 1);
-            float voltage = module->pointBuffer[op][(module->bufferIndex[op] + i) % BUFFER_SIZE];
-
-            Vec point;
-            point.x = t;
-            point.y = 0.5f - (voltage / 2); // -1 to 1
-
-            point = innerBox.size * point;
-
-            if (i == 0) {
+        for (int column = 0; column < SCOPE_COLUMNS; ++column) {
+            Vec point = columnPoint(innerBox, column, envelope.maximums[column]);
+            if (column == 0) {
                 nvgMoveTo(args.vg, point.x + 4, point.y + 4);
             } else {
                 nvgLineTo(args.vg, point.x + 4, point.y + 4);
             }
         }
 
+        for (int column = SCOPE_COLUMNS - 1; column >= 0; --column) {
+            Vec point = columnPoint(innerBox, column, envelope.minimums[column]);
+            nvgLineTo(args.vg, point.x + 4, point.y + 4);
+        }
+
+        nvgClosePath(args.vg);
+        nvgFillColor(args.vg, OPERATOR_COLOURS[op]);
+        nvgFill(args.vg);
+
         nvgStrokeWidth(args.vg, 1.f);
         nvgLineCap(args.vg, NVG_ROUND);
+        nvgLineJoin(args.vg, NVG_ROUND);
         nvgStrokeColor(args.vg, OPERATOR_COLOURS[op]);
         nvgStroke(args.vg);
     }
 
+    Vec columnPoint(const Rect& innerBox, int column, float voltage) {
+        Vec point;
+        point.x = (column + 0.5f) / SCOPE_COLUMNS;
+        point.y = 0.5f - (voltage / 2); // -1 to 1
+
+        return innerBox.size * point;
+    }
+
+    // Recalculated only when new points arrive, so drawing does no per-point work
+    ScopeEnvelope<SCOPE_COLUMNS> envelope;
     int op = 0;
 };
 
@@ -591,6 +790,141 @@ struct SpiderWidget : ModuleWidget {
 
         addChild(createParamCentered<ShinyBigKnob>(Vec(255.f, 334.59f), module, Spider::FREQ_PARAM));
     }
+
+    void step() override {
+        Spider* module = getModule<Spider>();
+        if (module) {
+            module->processEdit(APP->window->getLastFrameDuration());
+        }
+
+        ModuleWidget::step();
+    }
+
+    void appendContextMenu(Menu* menu) override {
+        Spider* module = getModule<Spider>();
+
+        menu->addChild(new MenuSeparator);
+
+        std::vector<std::string> algorithmLabels;
+        for (int i = 0; i < LIBRARY_ALGORITHM_COUNT; ++i) {
+            algorithmLabels.push_back("Algorithm " + std::to_string(i + 1));
+        }
+
+        // Nothing is checked once the routing has been edited by hand
+        menu->addChild(createIndexSubmenuItem(
+            "Algorithm library", algorithmLabels, [=]() { return size_t(module->libraryAlgorithm); },
+            [=](size_t index) { module->loadAlgorithm(index); }));
+
+        menu->addChild(createSubmenuItem("Modulation depth", "", [=](Menu* menu) {
+            bool connected = false;
+            for (int mod = 0; mod < OPERATOR_COUNT; ++mod) {
+                for (int op = 0; op < OPERATOR_COUNT; ++op) {
+                    if (module->algorithmGraph.hasEdge(mod, op)) {
+                        menu->addChild(new ModulationDepthSlider(module, mod, op));
+                        connected = true;
+                    }
+                }
+            }
+
+            if (!connected) {
+                menu->addChild(createMenuLabel("No connections"));
+            }
+        }));
+
+        std::vector<std::string> divisionLabels;
+        for (int division : CONTROL_DIVISIONS) {
+            divisionLabels.push_back("Every " + std::to_string(division) + " samples");
+        }
+
+        menu->addChild(createIndexSubmenuItem(
+            "Control rate", divisionLabels,
+            [=]() {
+                int division = module->engine.controlDivision;
+                auto it = std::find(CONTROL_DIVISIONS.begin(), CONTROL_DIVISIONS.end(), division);
+                return size_t(it - CONTROL_DIVISIONS.begin());
+            },
+            [=](size_t index) { module->engine.controlDivision = CONTROL_DIVISIONS[index]; }));
+
+        menu->addChild(createBoolPtrMenuItem("Audio rate CV inputs", "", &module->engine.audioRateCv));
+
+        menu->addChild(createBoolPtrMenuItem("Band-limited waveforms", "", &module->engine.bandLimited));
+
+        menu->addChild(createIndexSubmenuItem(
+            "Oversampling", {"Off", "2x", "4x", "8x"},
+            [=]() {
+                int factor = module->engine.oversampling;
+                auto it = std::find(OVERSAMPLING_FACTORS.begin(), OVERSAMPLING_FACTORS.end(), factor);
+                return size_t(it - OVERSAMPLING_FACTORS.begin());
+            },
+            [=](size_t index) { module->engine.oversampling = OVERSAMPLING_FACTORS[index]; }));
+
+        int hitPercent = int(100.f * module->scheduleCache.hitRate() + 0.5f);
+        menu->addChild(createMenuLabel("Routing cache hits: " + std::to_string(hitPercent) + "%"));
+
+#ifdef PH_PERF_COUNTERS
+        menu->addChild(createSubmenuItem("Performance", "", [=](Menu* menu) { appendPerfMenu(menu, module); }));
+#endif
+
+#ifdef PH_TRACE
+        // Stopping writes the trace from the UI thread
+        menu->addChild(createCheckMenuItem(
+            "Record trace", TRACE_FILE_NAME, []() { return TraceRecorder::instance().isRecording(); },
+            []() {
+                TraceRecorder& recorder = TraceRecorder::instance();
+                if (!recorder.isRecording()) {
+                    traceThreadName("UI");
+                    recorder.start();
+                } else if (!recorder.stop(asset::user(TRACE_FILE_NAME))) {
+                    WARN("Could not write %s", asset::user(TRACE_FILE_NAME).c_str());
+                }
+            }));
+#endif
+    }
+
+#ifdef PH_PERF_COUNTERS
+    // Counters since the last reset, read when the submenu opens
+    static void appendPerfMenu(Menu* menu, Spider* module) {
+        const SpiderPerf<OPERATOR_COUNT>& perf = module->engine.perf;
+        double usPerTick = 1e-3 / perf.clock.ticksPerNs();
+
+        auto timeLabel = [=](const std::string& name, const PerfCounter& counter) {
+            PerfCounter::Snapshot snapshot = counter.snapshot();
+            return createMenuLabel(string::f("%s: %.2f µs mean, %.2f µs max", name.c_str(),
+                                             snapshot.meanTicks() * usPerTick, snapshot.maxTicks * usPerTick));
+        };
+
+        menu->addChild(timeLabel("Frame", perf.process));
+        menu->addChild(timeLabel("Operators", perf.processOperators));
+
+        // Cycles per call, and each operator's share of the time spent in all of them
+        uint64_t operatorTicks = 0;
+        for (const PerfCounter& counter : perf.operators) {
+            operatorTicks += counter.snapshot().ticks;
+        }
+        for (int op = 0; op < OPERATOR_COUNT; ++op) {
+            PerfCounter::Snapshot snapshot = perf.operators[op].snapshot();
+            float share = operatorTicks ? 100.f * snapshot.ticks / operatorTicks : 0.f;
+            menu->addChild(createMenuLabel(
+                string::f("Operator %d: %.0f cycles per call, %.1f%%", op + 1, snapshot.meanTicks(), share)));
+        }
+
+        menu->addChild(timeLabel("Edit step", perf.edit));
+        menu->addChild(timeLabel("Edit to schedule", perf.scheduleLatency));
+        menu->addChild(createMenuLabel(string::f("Allocations: %llu audio, %llu edit",
+                                                 (unsigned long long)perf.audioAllocations.load(),
+                                                 (unsigned long long)perf.editAllocations.load())));
+
+        menu->addChild(new MenuSeparator);
+        menu->addChild(createMenuItem("Reset counters", "", [=]() { module->engine.perf.reset(); }));
+        menu->addChild(createMenuItem("Copy as JSON", "", [=]() {
+            json_t* rootJ = module->perfToJson();
+            char* text = json_dumps(rootJ, JSON_INDENT(2));
+            glfwSetClipboardString(APP->window->win, text);
+            std::free(text);
+            json_decref(rootJ);
+        }));
+    }
+#endif
 };
 
 } // namespace ph
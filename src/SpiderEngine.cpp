@@ -0,0 +1,486 @@
+#include "SpiderEngine.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ph {
+
+SpiderEngine::SpiderEngine() {
+    lastPitchShiftParam.fill(NAN);
+    wakeFade.setTarget(1.f, 0);
+}
+
+void SpiderEngine::renderBlock(const RenderArgs& args, const SpiderParams& params, int frames, const float* pitch,
+                               float* output) {
+    if (oversampling != activeOversampling) {
+        activeOversampling = oversampling;
+        for (auto& decimator : decimators) {
+            decimator.reset();
+        }
+    }
+
+    if (audioRateCv || snapControls) {
+        readControls(params, 0);
+        controlCountdown = controlDivision;
+        snapControls = false;
+    } else if (controlCountdown <= 0) {
+        readControls(params, std::max(frames, controlDivision));
+        controlCountdown = controlDivision;
+    }
+    controlCountdown -= frames;
+
+    // Only capture for the scopes while a display has been drawn recently
+    scopeCheckCountdown -= frames;
+    if (scopeCheckCountdown <= 0) {
+        scopesActive = scopesRequested.exchange(false);
+        scopeCheckCountdown = int(args.sampleRate * 0.25f);
+    }
+
+    updateLiveness();
+    processOperators(args, frames, pitch, output);
+
+    controls.pitch.advance(frames);
+    wakeFade.advance(frames);
+    for (int op = 0; op < OPERATOR_COUNT; ++op) {
+        controls.operators[op].advance(frames);
+    }
+}
+
+void SpiderEngine::sleep() {
+    idle = true;
+    outs.fill(0.f);
+    oldOuts.fill(0.f);
+}
+
+void SpiderEngine::wake(float sampleRate) {
+    idle = false;
+    snapControls = true;
+
+    for (auto& decimator : decimators) {
+        decimator.reset();
+    }
+
+    wakeFade.value = 0.f;
+    wakeFade.setTarget(1.f, std::max(1, int(sampleRate * WAKE_FADE_TIME)));
+}
+
+void SpiderEngine::readControls(const SpiderParams& params, int rampFrames) {
+    controls.pitch.setTarget(params.frequency / 12.f, rampFrames);
+
+    for (int op = 0; op < OPERATOR_COUNT; ++op) {
+        const OperatorParams& opParams = params.operators[op];
+        OperatorControls opControls;
+
+        float level = opParams.level + (opParams.levelInput / 10.f * opParams.levelCv);
+        opControls.level = clamp(level, 0.f, 1.f);
+
+        // The coarse pitch knob snaps to semitones so it rarely changes
+        if (opParams.pitch != lastPitchShiftParam[op]) {
+            float octaveShift = opParams.pitch / 12.0f;
+            coarseRatios[op] = dsp::exp2_taylor5(octaveShift); // +- 12 semitones coarse pitch
+            lastPitchShiftParam[op] = opParams.pitch;
+        }
+
+        opControls.coarseRatio = coarseRatios[op];
+        // +-12 semitones pitch shift
+        opControls.fineRatio = dsp::exp2_taylor5(opParams.pitchInput / 10.f * opParams.pitchCv);
+
+        float wavePos = opParams.wave + (opParams.waveCv * (opParams.waveInput / 10.f));
+        opControls.wavePos = clamp(wavePos, 0.f, 1.f);
+
+        opControls.feedback = opParams.feedback;
+
+        controls.operators[op].setTargets(opControls, rampFrames);
+    }
+}
+
+void SpiderEngine::reset() {
+    for (int i = 0; i < OPERATOR_COUNT; ++i) {
+        reset(i);
+    }
+}
+
+void SpiderEngine::reset(int op) {
+    for (int c = 0; c < MAX_CHANNEL_COUNT; c += 4) {
+        signalGenerators[op * SIMD_GROUP_COUNT + c / 4].reset();
+    }
+
+    scopeCountdown[op] = 0;
+    scopes[op].clear();
+}
+
+// Finds the operators worth evaluating this block. Silent operators, and operators that can't reach the output,
+// are skipped and their outputs held at zero. While the scopes are capturing, the first group of channels runs
+// every operator that isn't silent so unconnected operators still show on their scopes. The lists are kept until the
+// schedule, the silent operators or scopesActive change.
+void SpiderEngine::updateLiveness() {
+    uint32_t silent = 0;
+    for (int op = 0; op < OPERATOR_COUNT; ++op) {
+        if (controls.operators[op].isSilent()) {
+            silent |= 1u << op;
+        }
+    }
+
+    if (!livenessStale && silent == livenessSilent && scopesActive == livenessScopesActive) {
+        return;
+    }
+
+    PH_TRACE_SCOPE("liveness");
+    livenessStale = false;
+    livenessSilent = silent;
+    livenessScopesActive = scopesActive;
+
+    liveOperators.count = schedule.findLive(silent, liveOperators.order);
+    liveOperators.mask = 0;
+    for (int i = 0; i < liveOperators.count; ++i) {
+        liveOperators.mask |= 1u << liveOperators.order[i];
+    }
+
+    scopeOperators.count = 0;
+    scopeOperators.mask = 0;
+    for (int op : schedule.order) {
+        if (!(silent & (1u << op))) {
+            scopeOperators.order[scopeOperators.count++] = op;
+            scopeOperators.mask |= 1u << op;
+        }
+    }
+
+    const OperatorList& firstOperators = scopesActive ? scopeOperators : liveOperators;
+    wavefronts.build(schedule, firstOperators.order, firstOperators.count);
+}
+
+void SpiderEngine::processOperators(const RenderArgs& args, int frames, const float* pitch, float* output) {
+    PH_PERF_SCOPE(perf.processOperators);
+    PH_TRACE_SCOPE("operators");
+
+    // The operators run activeOversampling times per frame and the carrier sum is decimated back down
+    RenderArgs oversampledArgs = args;
+    oversampledArgs.sampleRate *= activeOversampling;
+    oversampledArgs.sampleTime /= activeOversampling;
+
+    // A single voice only fills one lane of each operator's vector. If the operators fit in fewer vectors
+    // across operators than there are operators, evaluate them that way instead.
+    if (channels == 1) {
+        const OperatorList& operators = scopesActive ? scopeOperators : liveOperators;
+        if (wavefronts.vectorCount < operators.count) {
+            processWavefronts(args, oversampledArgs, frames, pitch, output, operators);
+            return;
+        }
+    }
+
+    // A library algorithm runs on its own kernel, anything else on processFrame()
+    FrameKernel kernel = libraryKernel(schedule.libraryAlgorithm);
+
+    for (int c = 0; c < channels; c += 4) {
+        const OperatorList& operators = (c == 0 && scopesActive) ? scopeOperators : liveOperators;
+
+        // Keep the state of this group of channels in locals for the whole block
+        VoiceGroup voices;
+        loadVoiceGroup(voices, c, operators);
+
+        for (int frame = 0; frame < frames; ++frame) {
+            simd::float_4 voct = simd::float_4::load(&pitch[frame * MAX_CHANNEL_COUNT + c]);
+            simd::float_4 baseFreq = dsp::FREQ_C4 * dsp::exp2_taylor5(controls.pitch.at(frame) + voct);
+
+            std::array<OperatorControls, OPERATOR_COUNT> frameControls;
+            for (int i = 0; i < operators.count; ++i) {
+                int op = operators.order[i];
+                frameControls[op] = controls.operators[op].at(frame);
+            }
+
+            auto frameSum = [&](const RenderArgs& frameArgs) {
+                return kernel ? (this->*kernel)(frameArgs, voices, baseFreq, frameControls, operators)
+                              : processFrame(frameArgs, voices, baseFreq, frameControls, operators);
+            };
+
+            simd::float_4 sum;
+            if (activeOversampling == 1) {
+                sum = frameSum(args);
+            } else {
+                simd::float_4 subSamples[TOversamplingDecimator<>::MAX_FACTOR] = {};
+                for (int i = 0; i < activeOversampling; ++i) {
+                    subSamples[i] = frameSum(oversampledArgs);
+                }
+                sum = decimators[c / 4].process(subSamples, activeOversampling);
+            }
+
+            if (c == 0 && scopesActive) {
+                std::array<float, OPERATOR_COUNT + 1> firstOuts;
+                for (int op = 0; op < OPERATOR_COUNT; ++op) {
+                    firstOuts[op] = voices.outs[op][0];
+                }
+                captureScopes(args, firstOuts, baseFreq[0], frame);
+            }
+
+            if (wakeFade.isRamping()) {
+                sum *= wakeFade.at(frame);
+            }
+
+            simd::clamp(sum, -1.f, 1.f).store(&output[frame * MAX_CHANNEL_COUNT + c]);
+        }
+
+        storeVoiceGroup(voices, c);
+    }
+}
+
+// Runs each of the operators once and returns the sum of the carriers
+simd::float_4 SpiderEngine::processFrame(const RenderArgs& args, VoiceGroup& voices, simd::float_4 baseFreq,
+                                         const std::array<OperatorControls, OPERATOR_COUNT>& frameControls,
+                                         const OperatorList& operators) {
+    for (int i = 0; i < operators.count; ++i) {
+        int op = operators.order[i];
+        processOperator(op, frameControls, args, voices, baseFreq);
+    }
+
+    simd::float_4 sum = 0.f;
+    for (int i = 0; i < schedule.carrierCount; ++i) {
+        sum += voices.outs[schedule.carriers[i]];
+    }
+    return sum;
+}
+
+void SpiderEngine::processOperator(int op, const std::array<OperatorControls, OPERATOR_COUNT>& frameControls,
+                                   const RenderArgs& args, VoiceGroup& voices, simd::float_4 baseFreq) {
+    PH_PERF_SCOPE(perf.operators[op]);
+
+    const OperatorControls& opControls = frameControls[op];
+    simd::float_4 freq = baseFreq * opControls.coarseRatio;
+    freq *= opControls.fineRatio;
+
+    for (int i = 0; i < schedule.modulatorCounts[op]; ++i) {
+        int mod = schedule.modulators[op][i];
+        simd::float_4 modFreq = voices.freqs[mod];
+        if (schedule.fedBack[op][i]) {
+            modFreq = baseFreq * frameControls[mod].coarseRatio;
+            modFreq *= frameControls[mod].fineRatio;
+        }
+        freq += 5.f * schedule.modulationDepths[op][i] * modFreq * voices.outs[mod];
+    }
+
+    generateOperator(op, freq, opControls, args, voices);
+}
+
+// Operator-parallel version of processOperators() for a single voice. Each vector of the wavefront plan runs its
+// operators in the four lanes, and the operators' outputs pass between vectors through scalar arrays. Every lane
+// does the same arithmetic as the channel-parallel path, so the output is identical.
+void SpiderEngine::processWavefronts(const RenderArgs& args, const RenderArgs& oversampledArgs, int frames,
+                                     const float* pitch, float* output, const OperatorList& operators) {
+    // Channel 0 of every operator. Index OPERATOR_COUNT stands in for a missing modulator and stays zero.
+    WavefrontFreqs opFreqs = {};
+    std::array<float, OPERATOR_COUNT + 1> opOuts;
+    for (int op = 0; op < OPERATOR_COUNT; ++op) {
+        opFreqs[op] = freqs[op * MAX_CHANNEL_COUNT];
+        opOuts[op] = (operators.mask & (1u << op)) ? outs[op * MAX_CHANNEL_COUNT] : 0.f;
+    }
+    opOuts[OPERATOR_COUNT] = 0.f;
+
+    std::array<OperatorVector, OPERATOR_COUNT> vectors;
+    for (int v = 0; v < wavefronts.vectorCount; ++v) {
+        loadOperatorVector(vectors[v], v, opOuts);
+    }
+
+    for (int frame = 0; frame < frames; ++frame) {
+        simd::float_4 voct = pitch[frame * MAX_CHANNEL_COUNT];
+        simd::float_4 baseFreq = dsp::FREQ_C4 * dsp::exp2_taylor5(controls.pitch.at(frame) + voct);
+
+        std::array<OperatorVectorControls, OPERATOR_COUNT> frameControls;
+        for (int v = 0; v < wavefronts.vectorCount; ++v) {
+            frameControls[v] = vectors[v].at(frame);
+        }
+
+        float sum;
+        if (activeOversampling == 1) {
+            sum = processWavefrontFrame(args, vectors, baseFreq, frameControls, opFreqs, opOuts);
+        } else {
+            simd::float_4 subSamples[TOversamplingDecimator<>::MAX_FACTOR];
+            for (int i = 0; i < activeOversampling; ++i) {
+                subSamples[i] = 0.f;
+                subSamples[i][0] =
+                    processWavefrontFrame(oversampledArgs, vectors, baseFreq, frameControls, opFreqs, opOuts);
+            }
+            sum = decimators[0].process(subSamples, activeOversampling)[0];
+        }
+
+        if (scopesActive) {
+            captureScopes(args, opOuts, baseFreq[0], frame);
+        }
+
+        if (wakeFade.isRamping()) {
+            sum *= wakeFade.at(frame);
+        }
+
+        output[frame * MAX_CHANNEL_COUNT] = clamp(sum, -1.f, 1.f);
+    }
+
+    for (int op = 0; op < OPERATOR_COUNT; ++op) {
+        freqs[op * MAX_CHANNEL_COUNT] = opFreqs[op];
+        outs[op * MAX_CHANNEL_COUNT] = opOuts[op];
+    }
+
+    for (int v = 0; v < wavefronts.vectorCount; ++v) {
+        const OperatorVector& vector = vectors[v];
+        for (int lane = 0; lane < vector.laneCount; ++lane) {
+            signalGenerators[vector.ops[lane] * SIMD_GROUP_COUNT].phase[0] = vector.generator.phase[lane];
+        }
+    }
+}
+
+// Runs each vector of operators once and returns the sum of the carriers
+float SpiderEngine::processWavefrontFrame(const RenderArgs& args, std::array<OperatorVector, OPERATOR_COUNT>& vectors,
+                                          simd::float_4 baseFreq,
+                                          const std::array<OperatorVectorControls, OPERATOR_COUNT>& frameControls,
+                                          WavefrontFreqs& opFreqs, std::array<float, OPERATOR_COUNT + 1>& opOuts) {
+    // Operators fed back around a cycle are evaluated after those they modulate, so their unmodulated frequencies
+    // are found first
+    if (schedule.cyclic) {
+        for (int v = 0; v < wavefronts.vectorCount; ++v) {
+            const OperatorVector& vector = vectors[v];
+            simd::float_4 freq = baseFreq * frameControls[v].coarseRatio;
+            freq *= frameControls[v].fineRatio;
+            for (int lane = 0; lane < vector.laneCount; ++lane) {
+                opFreqs[OPERATOR_COUNT + 1 + vector.ops[lane]] = freq[lane];
+            }
+        }
+    }
+
+    for (int v = 0; v < wavefronts.vectorCount; ++v) {
+#ifdef PH_PERF_COUNTERS
+        uint64_t vectorStart = perfTicks();
+#endif
+        OperatorVector& vector = vectors[v];
+        const OperatorVectorControls& vectorControls = frameControls[v];
+
+        simd::float_4 freq = baseFreq * vectorControls.coarseRatio;
+        freq *= vectorControls.fineRatio;
+
+        // Lanes with fewer modulators add 0 * 0 * 0, which leaves their frequency unchanged
+        for (int i = 0; i < vector.modulatorCount; ++i) {
+            const std::array<int, 4>& mods = vector.modulators[i];
+            const std::array<int, 4>& modFreqs = vector.modulatorFreqs[i];
+            simd::float_4 modFreq(opFreqs[modFreqs[0]], opFreqs[modFreqs[1]], opFreqs[modFreqs[2]],
+                                  opFreqs[modFreqs[3]]);
+            simd::float_4 modOut(opOuts[mods[0]], opOuts[mods[1]], opOuts[mods[2]], opOuts[mods[3]]);
+            freq += 5.f * vector.modulationDepths[i] * modFreq * modOut;
+        }
+
+        simd::float_4 avgOldSample = (vector.outs + vector.oldOuts) / 2;
+
+        simd::float_4 feedback = 5.f * vectorControls.feedback * avgOldSample;
+
+        simd::float_4 signal;
+        if (bandLimited) {
+            signal = vector.generator.generateBandLimited(args.sampleTime, freq, vectorControls.wavePos, feedback);
+        } else {
+            signal = vector.generator.generate(args.sampleTime, freq, vectorControls.wavePos, feedback);
+        }
+        vector.outs = vectorControls.level * signal;
+
+        for (int lane = 0; lane < vector.laneCount; ++lane) {
+            opFreqs[vector.ops[lane]] = freq[lane];
+            opOuts[vector.ops[lane]] = vector.outs[lane];
+        }
+
+#ifdef PH_PERF_COUNTERS
+        // The lanes run together, so each operator is charged an equal share of the vector
+        uint64_t laneTicks = (perfTicks() - vectorStart) / vector.laneCount;
+        for (int lane = 0; lane < vector.laneCount; ++lane) {
+            perf.operators[vector.ops[lane]].add(laneTicks);
+        }
+#endif
+    }
+
+    float sum = 0.f;
+    for (int i = 0; i < schedule.carrierCount; ++i) {
+        sum += opOuts[schedule.carriers[i]];
+    }
+    return sum;
+}
+
+// Gathers the channel 0 state and control ramps of the operators in vector v of the wavefront plan
+void SpiderEngine::loadOperatorVector(OperatorVector& vector, int v,
+                                      const std::array<float, OPERATOR_COUNT + 1>& opOuts) {
+    vector.laneCount = wavefronts.laneCounts[v];
+    vector.modulatorCount = 0;
+    vector.outs = 0.f;
+    vector.oldOuts = 0.f;
+
+    for (int lane = 0; lane < 4; ++lane) {
+        for (int i = 0; i < OPERATOR_COUNT; ++i) {
+            vector.modulators[i][lane] = OPERATOR_COUNT;
+            vector.modulatorFreqs[i][lane] = OPERATOR_COUNT;
+            vector.modulationDepths[i][lane] = 0.f;
+        }
+
+        if (lane >= vector.laneCount) {
+            vector.ops[lane] = OPERATOR_COUNT;
+            continue;
+        }
+
+        int op = wavefronts.lanes[v][lane];
+        vector.ops[lane] = op;
+
+        for (int i = 0; i < schedule.modulatorCounts[op]; ++i) {
+            int mod = schedule.modulators[op][i];
+            vector.modulators[i][lane] = mod;
+            vector.modulatorFreqs[i][lane] = schedule.fedBack[op][i] ? OPERATOR_COUNT + 1 + mod : mod;
+            vector.modulationDepths[i][lane] = schedule.modulationDepths[op][i];
+        }
+        vector.modulatorCount = std::max(vector.modulatorCount, schedule.modulatorCounts[op]);
+
+        vector.outs[lane] = opOuts[op];
+        vector.oldOuts[lane] = oldOuts[op * MAX_CHANNEL_COUNT];
+        vector.generator.phase[lane] = signalGenerators[op * SIMD_GROUP_COUNT].phase[0];
+
+        const OperatorRamps& ramps = controls.operators[op];
+        vector.level.load(lane, ramps.level);
+        vector.coarseRatio.load(lane, ramps.coarseRatio);
+        vector.fineRatio.load(lane, ramps.fineRatio);
+        vector.wavePos.load(lane, ramps.wavePos);
+        vector.feedback.load(lane, ramps.feedback);
+    }
+}
+
+// Sends one point of the first channel per period of each operator's unmodulated frequency to its
+// scope. The points land slightly later in each period, which draws one cycle of the waveform.
+// firstOuts holds the output of each operator on the first channel.
+void SpiderEngine::captureScopes(const RenderArgs& args, const std::array<float, OPERATOR_COUNT + 1>& firstOuts,
+                                 float baseFreq, int frame) {
+    PH_TRACE_SCOPE("scope capture");
+
+    for (int op = 0; op < OPERATOR_COUNT; ++op) {
+        if (--scopeCountdown[op] > 0) {
+            continue;
+        }
+
+        OperatorControls opControls = controls.operators[op].at(frame);
+        float freq = baseFreq * opControls.coarseRatio;
+        freq *= opControls.fineRatio;
+
+        scopeCountdown[op] = std::max(1, int(args.sampleRate / freq));
+        scopes[op].push(firstOuts[op]);
+    }
+}
+
+// Operators that won't be evaluated output zero
+void SpiderEngine::loadVoiceGroup(VoiceGroup& voices, int c, const OperatorList& operators) {
+    for (int op = 0; op < OPERATOR_COUNT; ++op) {
+        voices.freqs[op] = simd::float_4::load(&freqs[op * MAX_CHANNEL_COUNT + c]);
+        if (operators.mask & (1u << op)) {
+            voices.outs[op] = simd::float_4::load(&outs[op * MAX_CHANNEL_COUNT + c]);
+        } else {
+            voices.outs[op] = 0.f;
+        }
+        voices.oldOuts[op] = simd::float_4::load(&oldOuts[op * MAX_CHANNEL_COUNT + c]);
+        voices.generators[op] = signalGenerators[op * SIMD_GROUP_COUNT + c / 4];
+    }
+}
+
+void SpiderEngine::storeVoiceGroup(VoiceGroup& voices, int c) {
+    for (int op = 0; op < OPERATOR_COUNT; ++op) {
+        voices.freqs[op].store(&freqs[op * MAX_CHANNEL_COUNT + c]);
+        voices.outs[op].store(&outs[op * MAX_CHANNEL_COUNT + c]);
+        signalGenerators[op * SIMD_GROUP_COUNT + c / 4] = voices.generators[op];
+    }
+}
+
+} // namespace ph
@@ -0,0 +1,344 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include "Dsp.hpp"
+#include "HalfBandDecimator.hpp"
+#include "LinearRamp.hpp"
+#include "PerfCounters.hpp"
+#include "RoutingSchedule.hpp"
+#include "ScopeCapture.hpp"
+#include "SignalGenerator.hpp"
+#include "TraceRecorder.hpp"
+
+namespace ph {
+
+constexpr int OPERATOR_COUNT = 6;
+constexpr int MAX_CHANNEL_COUNT = 16;
+constexpr int SIMD_GROUP_COUNT = MAX_CHANNEL_COUNT / 4;
+
+// Points of history in each operator's scope
+constexpr int SCOPE_SIZE = 512;
+
+// Params and CV inputs are sampled once every this many frames by default
+constexpr int DEFAULT_CONTROL_DIVISION = 16;
+
+// The output fades in over this long when the module wakes from idle
+constexpr float WAKE_FADE_TIME = 0.002f;
+
+// Values of one operator's params and CV inputs, as the module reads them
+struct OperatorParams {
+    float level;
+    float levelCv;
+    // Volts
+    float levelInput;
+    // Semitones
+    float pitch;
+    float pitchCv;
+    // Volts
+    float pitchInput;
+    float wave;
+    float waveCv;
+    // Volts
+    float waveInput;
+    float feedback;
+};
+
+struct SpiderParams {
+    // Semitones from C4
+    float frequency;
+    std::array<OperatorParams, OPERATOR_COUNT> operators;
+};
+
+struct RenderArgs {
+    float sampleRate;
+    float sampleTime;
+};
+
+// The Spider's DSP: the operators of every channel, the control ramps, oversampling and scope capture. It knows
+// nothing of Rack, so it also builds headless as libspidercore (`make core`). The module reads its params into a
+// SpiderParams and hands the engine a compiled RoutingSchedule; everything here runs on the audio thread except
+// the scopes, which a display reads from the UI thread.
+struct SpiderEngine {
+    // Control-rate copies of the params and CV inputs of one operator
+    struct OperatorControls {
+        float level = 0.f;
+        float coarseRatio = 1.f;
+        float fineRatio = 1.f;
+        float wavePos = 0.f;
+        float feedback = 0.f;
+    };
+
+    // Smooths an operator's controls from one control-rate sample to the next
+    struct OperatorRamps {
+        void setTargets(const OperatorControls& targets, int frames) {
+            level.setTarget(targets.level, frames);
+            coarseRatio.setTarget(targets.coarseRatio, frames);
+            fineRatio.setTarget(targets.fineRatio, frames);
+            wavePos.setTarget(targets.wavePos, frames);
+            feedback.setTarget(targets.feedback, frames);
+        }
+
+        OperatorControls at(int frame) const {
+            OperatorControls controls;
+            controls.level = level.at(frame);
+            controls.coarseRatio = coarseRatio.at(frame);
+            controls.fineRatio = fineRatio.at(frame);
+            controls.wavePos = wavePos.at(frame);
+            controls.feedback = feedback.at(frame);
+            return controls;
+        }
+
+        // The level is zero for the whole of the current ramp, so the operator outputs nothing
+        bool isSilent() const { return level.value == 0.f && level.target == 0.f; }
+
+        void advance(int frames) {
+            level.advance(frames);
+            coarseRatio.advance(frames);
+            fineRatio.advance(frames);
+            wavePos.advance(frames);
+            feedback.advance(frames);
+        }
+
+        LinearRamp level;
+        LinearRamp coarseRatio;
+        LinearRamp fineRatio;
+        LinearRamp wavePos;
+        LinearRamp feedback;
+    };
+
+    struct BlockControls {
+        LinearRamp pitch;
+        std::array<OperatorRamps, OPERATOR_COUNT> operators;
+    };
+
+    typedef TFixedPhaseSignalGenerator<simd::float_4> OperatorGenerator;
+
+    // Operators to evaluate in a block, in evaluation order
+    struct OperatorList {
+        std::array<int, OPERATOR_COUNT> order = {};
+        int count = 0;
+        uint32_t mask = 0;
+    };
+
+    // Four LinearRamps side by side, one per lane
+    struct RampLanes {
+        void load(int lane, const LinearRamp& ramp) {
+            value[lane] = ramp.value;
+            target[lane] = ramp.target;
+            step[lane] = ramp.step;
+            remaining[lane] = ramp.remaining;
+        }
+
+        // Same as LinearRamp::at() on every lane
+        simd::float_4 at(int frame) const {
+            float next = frame + 1;
+            return simd::ifelse(next < remaining, value + step * next, target);
+        }
+
+        simd::float_4 value = 0.f;
+        simd::float_4 target = 0.f;
+        simd::float_4 step = 0.f;
+        simd::float_4 remaining = 0.f;
+    };
+
+    // OperatorControls of the four operators in an OperatorVector
+    struct OperatorVectorControls {
+        simd::float_4 level;
+        simd::float_4 coarseRatio;
+        simd::float_4 fineRatio;
+        simd::float_4 wavePos;
+        simd::float_4 feedback;
+    };
+
+    // Up to four operators of the first channel evaluated side by side, one per lane. Lanes with no operator have
+    // zero controls and are never read back.
+    struct OperatorVector {
+        OperatorVectorControls at(int frame) const {
+            OperatorVectorControls controls;
+            controls.level = level.at(frame);
+            controls.coarseRatio = coarseRatio.at(frame);
+            controls.fineRatio = fineRatio.at(frame);
+            controls.wavePos = wavePos.at(frame);
+            controls.feedback = feedback.at(frame);
+            return controls;
+        }
+
+        std::array<int, 4> ops;
+        int laneCount;
+
+        // modulators[i][lane] is the i-th modulator of the operator in the lane, or OPERATOR_COUNT (always zero) if
+        // it has fewer than i + 1
+        std::array<std::array<int, 4>, OPERATOR_COUNT> modulators;
+        // Index of the frequency modulators[i][lane] modulates with in the WavefrontFreqs, its unmodulated one if it
+        // is fed back
+        std::array<std::array<int, 4>, OPERATOR_COUNT> modulatorFreqs;
+        std::array<simd::float_4, OPERATOR_COUNT> modulationDepths;
+        int modulatorCount;
+
+        simd::float_4 outs;
+        simd::float_4 oldOuts;
+        OperatorGenerator generator;
+
+        RampLanes level;
+        RampLanes coarseRatio;
+        RampLanes fineRatio;
+        RampLanes wavePos;
+        RampLanes feedback;
+    };
+
+    // Channel 0 frequencies of the operators in processWavefronts(). [0, OPERATOR_COUNT) are the operators'
+    // frequencies, OPERATOR_COUNT stands in for a missing modulator and stays zero, and OPERATOR_COUNT + 1 + op is
+    // the unmodulated frequency of op in the current frame, only kept for a cyclic schedule.
+    typedef std::array<float, 2 * OPERATOR_COUNT + 1> WavefrontFreqs;
+
+    // One group of four channels of every operator
+    struct VoiceGroup {
+        simd::float_4 freqs[OPERATOR_COUNT];
+        simd::float_4 outs[OPERATOR_COUNT];
+        simd::float_4 oldOuts[OPERATOR_COUNT];
+        OperatorGenerator generators[OPERATOR_COUNT];
+    };
+
+    SpiderEngine();
+
+    // True when the next renderBlock() reads params, so callers only need to fill them in then
+    bool controlsDue() const { return audioRateCv || snapControls || controlCountdown <= 0; }
+
+    // Renders `frames` frames for every active channel. pitch holds the 1V/Oct voltage of each
+    // frame and output receives the clamped carrier sum, both laid out [frame * MAX_CHANNEL_COUNT + c].
+    // Params and CV inputs are read at most once per block, every controlDivision frames, and ramped
+    // towards over the following frames. With audioRateCv they are read every block without a ramp.
+    void renderBlock(const RenderArgs& args, const SpiderParams& params, int frames, const float* pitch,
+                     float* output);
+
+    // Nothing can be heard, so the DSP stops until there is something to hear again. Generator phases are kept and
+    // the operator outputs are cleared, the same state as a freshly created engine.
+    void sleep();
+
+    // Picks the controls up where they are now rather than ramping from before the sleep, drops the stale
+    // oversampling history and fades the output in so waking doesn't click
+    void wake(float sampleRate);
+
+    void reset();
+    void reset(int op);
+
+    // Samples the params and CV inputs and ramps the controls to them over rampFrames frames
+    void readControls(const SpiderParams& params, int rampFrames);
+
+    // Takes over a schedule compiled elsewhere
+    void setSchedule(const RoutingSchedule<OPERATOR_COUNT>& newSchedule) {
+        schedule = newSchedule;
+        livenessStale = true;
+    }
+
+    void updateLiveness();
+    void processOperators(const RenderArgs& args, int frames, const float* pitch, float* output);
+    simd::float_4 processFrame(const RenderArgs& args, VoiceGroup& voices, simd::float_4 baseFreq,
+                               const std::array<OperatorControls, OPERATOR_COUNT>& frameControls,
+                               const OperatorList& operators);
+    void processOperator(int op, const std::array<OperatorControls, OPERATOR_COUNT>& frameControls,
+                         const RenderArgs& args, VoiceGroup& voices, simd::float_4 baseFreq);
+
+    // The rest of processOperator() once freq includes the modulation
+    void generateOperator(int op, simd::float_4 freq, const OperatorControls& opControls, const RenderArgs& args,
+                          VoiceGroup& voices) {
+        simd::float_4 avgOldSample = (voices.outs[op] + voices.oldOuts[op]) / 2;
+
+        simd::float_4 feedback = 5.f * opControls.feedback * avgOldSample;
+
+        voices.freqs[op] = freq;
+
+        auto& generator = voices.generators[op];
+        simd::float_4 signal;
+        if (bandLimited) {
+            signal = generator.generateBandLimited(args.sampleTime, freq, opControls.wavePos, feedback);
+        } else {
+            signal = generator.generate(args.sampleTime, freq, opControls.wavePos, feedback);
+        }
+        voices.outs[op] = opControls.level * signal;
+    }
+
+    // processFrame() specialised for one library algorithm, its routing unrolled from the table at compile time. The
+    // channel-parallel path renders a schedule marked with a libraryAlgorithm on it, see LibraryKernels.cpp.
+    typedef simd::float_4 (SpiderEngine::*FrameKernel)(const RenderArgs&, VoiceGroup&, simd::float_4,
+                                                       const std::array<OperatorControls, OPERATOR_COUNT>&,
+                                                       const OperatorList&);
+    template <int A>
+    simd::float_4 processLibraryFrame(const RenderArgs& args, VoiceGroup& voices, simd::float_4 baseFreq,
+                                      const std::array<OperatorControls, OPERATOR_COUNT>& frameControls,
+                                      const OperatorList& operators);
+    // The kernel of library algorithm index, or null for -1
+    static FrameKernel libraryKernel(int index);
+
+    void processWavefronts(const RenderArgs& args, const RenderArgs& oversampledArgs, int frames, const float* pitch,
+                           float* output, const OperatorList& operators);
+    float processWavefrontFrame(const RenderArgs& args, std::array<OperatorVector, OPERATOR_COUNT>& vectors,
+                                simd::float_4 baseFreq,
+                                const std::array<OperatorVectorControls, OPERATOR_COUNT>& frameControls,
+                                WavefrontFreqs& opFreqs,
+                                std::array<float, OPERATOR_COUNT + 1>& opOuts);
+    void loadOperatorVector(OperatorVector& vector, int v, const std::array<float, OPERATOR_COUNT + 1>& opOuts);
+    void captureScopes(const RenderArgs& args, const std::array<float, OPERATOR_COUNT + 1>& firstOuts, float baseFreq,
+                       int frame);
+    void loadVoiceGroup(VoiceGroup& voices, int c, const OperatorList& operators);
+    void storeVoiceGroup(VoiceGroup& voices, int c);
+
+    // Compiled by the module on the UI thread and handed over between blocks through setSchedule()
+    RoutingSchedule<OPERATOR_COUNT> schedule;
+
+    // Each generator runs four polyphony channels, indexed [op * SIMD_GROUP_COUNT + c / 4]
+    std::array<OperatorGenerator, OPERATOR_COUNT * SIMD_GROUP_COUNT> signalGenerators;
+
+    // Per-operator channel buffers, indexed [op * MAX_CHANNEL_COUNT + c]
+    alignas(16) std::array<float, OPERATOR_COUNT * MAX_CHANNEL_COUNT> freqs = {};
+    alignas(16) std::array<float, OPERATOR_COUNT * MAX_CHANNEL_COUNT> outs = {};
+
+    // Store previous samples to calculate operator feedback
+    alignas(16) std::array<float, OPERATOR_COUNT * MAX_CHANNEL_COUNT> oldOuts = {};
+    int channels = -1;
+
+    // Read the shared band-limited wavetable instead of the analytic waveforms
+    bool bandLimited = false;
+
+    // Set from the context menu, the audio thread switches to it at the start of the next block
+    int oversampling = 1;
+    int activeOversampling = 1;
+    std::array<TOversamplingDecimator<simd::float_4>, SIMD_GROUP_COUNT> decimators;
+
+    // Scope displays only show the first channel. Displays set scopesRequested whenever they draw.
+    std::array<ScopeCapture<SCOPE_SIZE>, OPERATOR_COUNT> scopes;
+    std::array<int, OPERATOR_COUNT> scopeCountdown = {};
+    std::atomic<bool> scopesRequested{false};
+    bool scopesActive = false;
+    int scopeCheckCountdown = 0;
+
+    BlockControls controls;
+    LinearRamp wakeFade;
+    bool idle = false;
+    OperatorList liveOperators;
+    OperatorList scopeOperators;
+    // What liveOperators, scopeOperators and wavefronts were last built from
+    bool livenessStale = true;
+    uint32_t livenessSilent = 0;
+    bool livenessScopesActive = false;
+    // Operator-parallel plan for the first channel's operators, used when there is only one channel
+    WavefrontPlan<OPERATOR_COUNT> wavefronts;
+    int controlDivision = DEFAULT_CONTROL_DIVISION;
+    int controlCountdown = 0;
+    bool audioRateCv = false;
+    // Jump straight to the next control values instead of ramping to them
+    bool snapControls = true;
+
+    // Coarse pitch ratios are only recalculated when the knob moves. NaN forces the first calculation.
+    std::array<float, OPERATOR_COUNT> lastPitchShiftParam;
+    std::array<float, OPERATOR_COUNT> coarseRatios = {};
+
+#ifdef PH_PERF_COUNTERS
+    // Shown in the module's Performance menu
+    SpiderPerf<OPERATOR_COUNT> perf;
+#endif
+};
+
+} // namespace ph
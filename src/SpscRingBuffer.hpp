@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace ph {
+
+// Lock-free queue for one producer thread and one consumer thread, the same as Rack's dsp::RingBuffer but without
+// the Rack dependency so the DSP core builds headless. SIZE must be a power of two. The indices run freely and wrap
+// at SIZE only when they index the buffer, so a full buffer is told apart from an empty one.
+template <typename T, size_t SIZE>
+struct SpscRingBuffer {
+    static_assert(SIZE > 0 && (SIZE & (SIZE - 1)) == 0, "SIZE must be a power of two");
+
+    // Producer. Only call when not full().
+    void push(T value) {
+        size_t i = end.load(std::memory_order_relaxed);
+        data[i & (SIZE - 1)] = value;
+        end.store(i + 1, std::memory_order_release);
+    }
+
+    // Consumer. Only call when not empty().
+    T shift() {
+        size_t i = start.load(std::memory_order_relaxed);
+        T value = data[i & (SIZE - 1)];
+        start.store(i + 1, std::memory_order_release);
+        return value;
+    }
+
+    bool empty() const { return start.load(std::memory_order_acquire) == end.load(std::memory_order_acquire); }
+    bool full() const { return size() >= SIZE; }
+    size_t size() const { return end.load(std::memory_order_acquire) - start.load(std::memory_order_acquire); }
+
+    // Only call while neither thread is using the buffer
+    void clear() {
+        start.store(0);
+        end.store(0);
+    }
+
+    std::array<T, SIZE> data;
+    std::atomic<size_t> start{0};
+    std::atomic<size_t> end{0};
+};
+
+} // namespace ph
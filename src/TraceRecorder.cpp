@@ -0,0 +1,138 @@
+#include "TraceRecorder.hpp"
+
+#ifdef PH_TRACE
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+
+namespace ph {
+
+namespace {
+
+thread_local TraceThreadBuffer* currentBuffer = nullptr;
+thread_local bool bufferClaimed = false;
+
+// How often the flush thread drains the buffers
+constexpr std::chrono::milliseconds FLUSH_INTERVAL(2);
+
+} // anonymous namespace
+
+TraceRecorder TraceRecorder::recorder;
+
+TraceRecorder::~TraceRecorder() {
+    recording.store(false);
+    flushing.store(false);
+    if (flushThread.joinable()) {
+        flushThread.join();
+    }
+}
+
+TraceThreadBuffer* TraceRecorder::threadBuffer() {
+    if (!bufferClaimed) {
+        bufferClaimed = true;
+        int index = threadCount.fetch_add(1, std::memory_order_relaxed);
+        if (index < MAX_THREADS) {
+            currentBuffer = &buffers[index];
+        }
+    }
+    return currentBuffer;
+}
+
+bool TraceRecorder::start() {
+    if (recording.load() || flushing.load()) {
+        return false;
+    }
+
+    // Events recorded after the last stop() are thrown away
+    drain();
+    for (int i = 0; i < MAX_THREADS; ++i) {
+        flushed[i].clear();
+        buffers[i].dropped.store(0);
+    }
+    flushedCount = 0;
+    flushDropped = 0;
+    untracedDropped.store(0);
+    startTime = traceNow();
+
+    flushing.store(true);
+    flushThread = std::thread(&TraceRecorder::flushLoop, this);
+    recording.store(true);
+    return true;
+}
+
+bool TraceRecorder::stop(const std::string& path) {
+    if (!recording.exchange(false)) {
+        return false;
+    }
+    flushing.store(false);
+    flushThread.join();
+    drain();
+
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        return false;
+    }
+
+    // Chrome's trace event format, timestamps in microseconds from start()
+    std::fprintf(file, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+    bool first = true;
+    int threads = std::min(threadCount.load(), MAX_THREADS);
+    for (int tid = 0; tid < threads; ++tid) {
+        const char* name = buffers[tid].name.load();
+        if (name) {
+            std::fprintf(file, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, "
+                               "\"args\": {\"name\": \"%s\"}}",
+                         first ? "" : ",\n", tid, name);
+            first = false;
+        }
+
+        for (const TraceEvent& event : flushed[tid]) {
+            if (event.begin < startTime) {
+                continue;
+            }
+            std::fprintf(file, "%s{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, "
+                               "\"dur\": %.3f}",
+                         first ? "" : ",\n", event.name, tid, (event.begin - startTime) / 1e3,
+                         (event.end - event.begin) / 1e3);
+            first = false;
+        }
+    }
+    std::fprintf(file, "\n], \"otherData\": {\"droppedEvents\": \"%" PRIu64 "\"}}\n", droppedEvents());
+
+    return std::fclose(file) == 0;
+}
+
+uint64_t TraceRecorder::droppedEvents() const {
+    uint64_t dropped = flushDropped + untracedDropped.load(std::memory_order_relaxed);
+    for (const TraceThreadBuffer& buffer : buffers) {
+        dropped += buffer.dropped.load(std::memory_order_relaxed);
+    }
+    return dropped;
+}
+
+void TraceRecorder::flushLoop() {
+    while (flushing.load()) {
+        drain();
+        std::this_thread::sleep_for(FLUSH_INTERVAL);
+    }
+}
+
+void TraceRecorder::drain() {
+    for (int i = 0; i < MAX_THREADS; ++i) {
+        auto& events = buffers[i].events;
+        while (!events.empty()) {
+            TraceEvent event = events.shift();
+            if (flushedCount < MAX_FLUSHED_EVENTS) {
+                flushed[i].push_back(event);
+                ++flushedCount;
+            } else {
+                ++flushDropped;
+            }
+        }
+    }
+}
+
+} // namespace ph
+
+#endif
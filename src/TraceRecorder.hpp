@@ -0,0 +1,150 @@
+#pragma once
+
+// Optional timeline tracing, built in with PH_TRACE (`make TRACE=1`). Without it PH_TRACE_SCOPE expands to nothing
+// and none of this is compiled.
+//
+// Each thread records into its own preallocated SpscRingBuffer, so recording never locks or allocates. A flush
+// thread started by TraceRecorder::start() drains the buffers, and stop() writes everything as Chrome trace JSON,
+// which chrome://tracing and the Perfetto UI open. A thread keeps its buffer until the library unloads, so only the
+// first TraceRecorder::MAX_THREADS threads ever to record are traced. Events from later threads are counted as dropped.
+
+#ifdef PH_TRACE
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SpscRingBuffer.hpp"
+
+namespace ph {
+
+inline uint64_t traceNow() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// One complete event. name must be a string literal, only the pointer is kept.
+struct TraceEvent {
+    const char* name;
+    uint64_t begin;
+    uint64_t end;
+};
+
+struct TraceThreadBuffer {
+    // Events held between flushes
+    static constexpr size_t SIZE = 1 << 16;
+
+    // Owning thread. Events that don't fit are counted and dropped.
+    void record(const char* name, uint64_t begin, uint64_t end) {
+        if (events.full()) {
+            dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return;
+        }
+        events.push(TraceEvent{name, begin, end});
+    }
+
+    SpscRingBuffer<TraceEvent, SIZE> events;
+    std::atomic<uint64_t> dropped{0};
+    // Set by traceThreadName(), shown as the thread's name in the viewer
+    std::atomic<const char*> name{nullptr};
+};
+
+class TraceRecorder {
+public:
+    // Threads beyond this many aren't traced. Buffers aren't reclaimed when their thread exits, so this counts every
+    // thread that has recorded since the library loaded.
+    static constexpr int MAX_THREADS = 16;
+
+    static TraceRecorder& instance() { return recorder; }
+
+    // Clears anything recorded so far, starts recording and starts the flush thread. Returns false if already
+    // recording.
+    bool start();
+    // Stops recording and writes the trace to path. Returns false if it couldn't be written.
+    bool stop(const std::string& path);
+
+    bool isRecording() const { return recording.load(std::memory_order_relaxed); }
+
+    // The calling thread's buffer, claimed on first use. nullptr once every buffer is taken.
+    TraceThreadBuffer* threadBuffer();
+
+    // Any thread without a buffer, for an event it couldn't record
+    void dropUntraced() { untracedDropped.fetch_add(1, std::memory_order_relaxed); }
+
+    // Events dropped since start() because a buffer was full or the thread had no buffer
+    uint64_t droppedEvents() const;
+
+private:
+    TraceRecorder() {}
+    // Joins the flush thread if a trace was still recording when the library unloads
+    ~TraceRecorder();
+
+    // Created when the library loads, so no thread ever constructs it mid-block
+    static TraceRecorder recorder;
+
+    void flushLoop();
+    // Moves every buffered event into flushed. Only the flush thread, or any thread once it has stopped.
+    void drain();
+
+    std::array<TraceThreadBuffer, MAX_THREADS> buffers;
+    std::atomic<int> threadCount{0};
+    std::atomic<bool> recording{false};
+    std::atomic<bool> flushing{false};
+    std::thread flushThread;
+    uint64_t startTime = 0;
+    std::atomic<uint64_t> untracedDropped{0};
+
+    // Events of each buffer, already drained. Past MAX_FLUSHED_EVENTS in total they are dropped.
+    static constexpr size_t MAX_FLUSHED_EVENTS = 1 << 22;
+    std::array<std::vector<TraceEvent>, MAX_THREADS> flushed;
+    size_t flushedCount = 0;
+    uint64_t flushDropped = 0;
+};
+
+// Names the calling thread in the trace. name must be a string literal.
+inline void traceThreadName(const char* name) {
+    TraceThreadBuffer* buffer = TraceRecorder::instance().threadBuffer();
+    if (buffer) {
+        buffer->name.store(name, std::memory_order_relaxed);
+    }
+}
+
+// Records the time from construction to destruction while a trace is recording
+struct TraceScope {
+    explicit TraceScope(const char* name)
+        : name(name)
+        , begin(TraceRecorder::instance().isRecording() ? traceNow() : 0) {}
+
+    ~TraceScope() {
+        if (begin == 0) {
+            return;
+        }
+        TraceRecorder& recorder = TraceRecorder::instance();
+        TraceThreadBuffer* buffer = recorder.threadBuffer();
+        if (buffer) {
+            buffer->record(name, begin, traceNow());
+        } else {
+            recorder.dropUntraced();
+        }
+    }
+
+    const char* name;
+    uint64_t begin;
+};
+
+} // namespace ph
+
+#define PH_TRACE_CONCAT_(a, b) a##b
+#define PH_TRACE_CONCAT(a, b) PH_TRACE_CONCAT_(a, b)
+// Records the rest of the enclosing scope as an event called name, a string literal
+#define PH_TRACE_SCOPE(name) ::ph::TraceScope PH_TRACE_CONCAT(traceScope, __LINE__)(name)
+
+#else
+
+#define PH_TRACE_SCOPE(name)
+
+#endif
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+
+namespace ph {
+
+// Frozen copy of the original signal generator and its sine table, so a change to how the engine's generators sound
+// shows up against the reference engine. Only the names differ from the original. Its quirks are kept: the sine table
+// clamps its index, the sine to triangle segment ignores phase modulation on the triangle, and the square reads a
+// negative phase as its first half.
+namespace frozen {
+
+// The original sine, linear interpolation between 256 samples with the index clamped rather than wrapped. A sine
+// backend (see SineBackend.hpp) for the float overload only.
+struct OriginalSineTable {
+    static constexpr int SIZE = 256;
+
+    static const std::array<float, SIZE>& table() {
+        static const std::array<float, SIZE> values = [] {
+            std::array<float, SIZE> t;
+            for (int i = 0; i < SIZE; ++i) {
+                t[i] = std::sin(2.0f * M_PI * i / SIZE);
+            }
+            return t;
+        }();
+        return values;
+    }
+
+    static float sin2pi(float x) {
+        const std::array<float, SIZE>& t = table();
+        x *= SIZE;
+        int i = (int)x;
+        if (i < 0) {
+            i = 0;
+        } else if (i >= SIZE - 1) {
+            i = SIZE - 1;
+        }
+        float f = x - i;
+        return (1.0f - f) * t[i] + f * t[(i + 1) % SIZE];
+    }
+};
+
+inline float triangle(float x) {
+    return 4.f * std::abs(std::round(x) - x) - 1.f;
+}
+inline float saw(float x) {
+    return 2.f * (x - std::round(x));
+}
+inline float square(float x) {
+    return (x < 0.5f) ? 1.f : -1.f;
+}
+
+inline float normalisePhase(float phase) {
+    float normalisedPhase = (phase < 0.f) ? phase + 1.f : phase;
+    return std::fmod(normalisedPhase, 1.f);
+}
+
+// rack::crossfade()
+inline float crossfade(float a, float b, float p) {
+    return a + (b - a) * p;
+}
+
+// The four-way branching generator that morphWave() replaced. Sine is the original table by default, the tests of
+// the morph kernel pass the engine's backend so the two differ only in how they blend.
+template <typename Sine = OriginalSineTable>
+struct TBranchingSignalGenerator {
+    float generate(float sampleTime, float freq, float wavePos, float phaseMod = 0) {
+        phase += freq * sampleTime;
+
+        if (phase > 1.f)
+            phase -= 1.f;
+        if (phase < -1.f)
+            phase += 1.f;
+
+        float normalisedPM = normalisePhase(phase + (phaseMod / (2 * M_PI)));
+        float PM = phase + phaseMod / (2 * M_PI);
+        PM = std::fmod(PM, 1.f);
+        float blend = 0.f;
+
+        if (wavePos <= 0.25f) {
+            blend = crossfade(Sine::sin2pi(normalisedPM), triangle(phase), wavePos / 0.25f);
+        } else if (wavePos <= 0.5f) {
+            blend = crossfade(triangle(PM), saw(PM), (wavePos - 0.25f) / 0.25f);
+        } else if (wavePos <= 0.75f) {
+            blend = crossfade(saw(PM), square(PM), (wavePos - 0.5f) / 0.25f);
+        } else {
+            blend = crossfade(square(PM), Sine::sin2pi(normalisedPM), (wavePos - 0.75f) / 0.25f);
+        }
+
+        return blend;
+    }
+
+    void reset() { phase = 0.f; }
+
+    float phase = 0.f;
+};
+
+typedef TBranchingSignalGenerator<> BranchingSignalGenerator;
+
+} // namespace frozen
+
+} // namespace ph
@@ -0,0 +1,327 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+#include "../src/FixedDirectedGraph.hpp"
+#include "../src/RoutingSchedule.hpp"
+#include "test_constants.hpp"
+#include "ReferenceEngine.hpp"
+
+namespace ph {
+
+// Randomised differential testing of SpiderEngine against the frozen ReferenceEngine. A case is a random routing
+// built through DirectedGraph, acyclic apart from in FEEDBACK_LOOPS, random carriers, depths and params, random CV
+// streams and a channel count. Each mode runs the engine one way and checks the largest difference from the reference
+// against its tolerance.
+// The exact modes give the reference the engine's own generator, so they check the loop around it. FROZEN_GENERATOR
+// keeps the reference's frozen copy of the original generator, so it hears a change to how the generators sound.
+//
+// Oversampling isn't compared, the decimator's latency shifts the output by a fraction of a sample.
+enum class DifferentialMode {
+    // Params and CV change every frame and the engine renders one frame at a time with audio rate CV, like
+    // Spider::process(). Compared with the fixed phase reference, so SIMD, wavefronts, pruning and the schedule
+    // must be exact.
+    AUDIO_RATE,
+    // Static params, 1V/Oct changing every frame, random block sizes. Exact as above.
+    BLOCKS,
+    // Static params read at control rate with a random division and random block sizes. Exact as above.
+    CONTROL_RATE,
+    // As AUDIO_RATE but compared with the original generator over 4096 frames. Half the cases are routed with
+    // shallow modulation and the continuous sine to triangle blends. The other half are unrouted and sweep every
+    // waveform. There is no feedback, as the original ignored phase modulation on the triangle and misread a
+    // negative phase on the square, which were fixed on purpose.
+    //
+    // The original's float phase drifts by rounding where the fixed phase doesn't. Deep modulation is chaotic enough
+    // to grow that drift to full scale. On a saw or square edge it can put the two on opposite sides of the jump, so
+    // a few samples, see differentialOutliersAllowed(), may differ by more than the tolerance.
+    FROZEN_GENERATOR,
+    // Band-limited wavetable against the analytic waveforms, unrouted sine to triangle blends at low pitches without
+    // feedback, where the harmonics the wavetable drops are negligible.
+    BAND_LIMITED,
+    // As AUDIO_RATE with at least one loop between operators, where an operator hears the modulators after it in the
+    // order a sample late. Exact as above, and every frequency the engine computes must stay finite.
+    FEEDBACK_LOOPS,
+};
+
+constexpr int DIFFERENTIAL_MODE_COUNT = 6;
+
+inline const char* differentialModeName(DifferentialMode mode) {
+    switch (mode) {
+        case DifferentialMode::AUDIO_RATE: return "audio rate";
+        case DifferentialMode::BLOCKS: return "blocks";
+        case DifferentialMode::CONTROL_RATE: return "control rate";
+        case DifferentialMode::FROZEN_GENERATOR: return "frozen generator";
+        case DifferentialMode::BAND_LIMITED: return "band-limited";
+        case DifferentialMode::FEEDBACK_LOOPS: return "feedback loops";
+    }
+    return "";
+}
+
+// Largest difference allowed from the reference on any sample of any channel, full scale being 1
+inline float differentialTolerance(DifferentialMode mode) {
+    switch (mode) {
+        case DifferentialMode::AUDIO_RATE:
+        case DifferentialMode::BLOCKS:
+        case DifferentialMode::CONTROL_RATE:
+        case DifferentialMode::FEEDBACK_LOOPS: return 1e-6f;
+        case DifferentialMode::FROZEN_GENERATOR: return 1e-3f;
+        case DifferentialMode::BAND_LIMITED: return 2e-2f;
+    }
+    return 0.f;
+}
+
+// Samples past the tolerance a case may have out of samples compared, one in 4096 in FROZEN_GENERATOR and none
+// otherwise. A real change in sound puts thousands of samples past it.
+inline long differentialOutliersAllowed(DifferentialMode mode, long samples) {
+    return (mode == DifferentialMode::FROZEN_GENERATOR) ? (samples + 4095) / 4096 : 0;
+}
+
+struct DifferentialCase {
+    DifferentialMode mode;
+    DirectedGraph<int> graph{OPERATOR_COUNT};
+    // {src, dest} edges graph refused for closing a cycle, FEEDBACK_LOOPS only
+    std::vector<std::pair<int, int>> loopEdges;
+    std::array<bool, OPERATOR_COUNT> carriers = {};
+    std::array<std::array<float, OPERATOR_COUNT>, OPERATOR_COUNT> depths = {};
+    int channels = 1;
+    int frames = 0;
+    int controlDivision = DEFAULT_CONTROL_DIVISION;
+    // Frames in each renderBlock() call, summing to frames
+    std::vector<int> blockSizes;
+    // Params and CV of each frame
+    std::vector<SpiderParams> params;
+    // 1V/Oct of each frame, [frame * MAX_CHANNEL_COUNT + c]
+    std::vector<float> pitch;
+};
+
+struct DifferentialResult {
+    // Largest difference, and where it was
+    float error = 0.f;
+    int frame = -1;
+    int channel = -1;
+    // Samples past the mode's tolerance, out of samples compared
+    long outliers = 0;
+    long samples = 0;
+    // False if the engine computed an infinite or NaN frequency
+    bool finite = true;
+
+    bool passed(DifferentialMode mode) const {
+        return finite && outliers <= differentialOutliersAllowed(mode, samples);
+    }
+};
+
+// Builds the case for seed. The same seed and mode always give the same case.
+inline DifferentialCase randomDifferentialCase(uint64_t seed, DifferentialMode mode) {
+    std::mt19937_64 rng(seed);
+    auto uniform = [&](float a, float b) { return std::uniform_real_distribution<float>(a, b)(rng); };
+    auto integer = [&](int a, int b) { return std::uniform_int_distribution<int>(a, b)(rng); };
+    auto chance = [&](float p) { return uniform(0.f, 1.f) < p; };
+
+    bool frozen = mode == DifferentialMode::FROZEN_GENERATOR;
+    bool loops = mode == DifferentialMode::FEEDBACK_LOOPS;
+    bool routed = (mode != DifferentialMode::BAND_LIMITED) && (!frozen || chance(0.5f));
+    bool varyingCv = mode == DifferentialMode::AUDIO_RATE || frozen || loops;
+    bool smoothWaves = mode == DifferentialMode::BAND_LIMITED || (frozen && routed);
+    float maxDepth = frozen ? 0.05f : 2.f;
+    float maxFeedback = frozen ? 0.f : 1.f;
+
+    DifferentialCase testCase;
+    testCase.mode = mode;
+    testCase.channels = integer(1, MAX_CHANNEL_COUNT);
+    testCase.frames = frozen ? 4096 : 1024;
+
+    // Edges that would close a cycle are refused, which leaves a random DAG. FEEDBACK_LOOPS keeps them as loop edges,
+    // starting from a loop between two operators.
+    if (loops) {
+        int a = integer(0, OPERATOR_COUNT - 1);
+        int b = (a + integer(1, OPERATOR_COUNT - 1)) % OPERATOR_COUNT;
+        testCase.graph.addEdge(a, b);
+        testCase.loopEdges.push_back(std::make_pair(b, a));
+    }
+
+    if (routed) {
+        float density = uniform(0.f, 0.6f);
+        for (int src = 0; src < OPERATOR_COUNT; ++src) {
+            for (int dest = 0; dest < OPERATOR_COUNT; ++dest) {
+                bool loopEdge = std::find(testCase.loopEdges.begin(), testCase.loopEdges.end(),
+                                          std::make_pair(src, dest)) != testCase.loopEdges.end();
+                if (src == dest || testCase.graph.hasEdge(src, dest) || loopEdge || !chance(density)) {
+                    continue;
+                }
+                if (testCase.graph.addEdge(src, dest) == ToggleEdgeResult::CYCLE && loops) {
+                    testCase.loopEdges.push_back(std::make_pair(src, dest));
+                }
+            }
+        }
+    }
+
+    for (int op = 0; op < OPERATOR_COUNT; ++op) {
+        testCase.carriers[op] = chance(0.4f);
+        for (int mod = 0; mod < OPERATOR_COUNT; ++mod) {
+            testCase.depths[mod][op] = uniform(0.f, maxDepth);
+        }
+    }
+    testCase.carriers[integer(0, OPERATOR_COUNT - 1)] = true;
+
+    SpiderParams base;
+    base.frequency = (mode == DifferentialMode::BAND_LIMITED) ? uniform(-36.f, 0.f) : uniform(-24.f, 24.f);
+
+    for (auto& opParams : base.operators) {
+        // The engine holds the phase of a silent operator where the reference keeps it running, so an operator
+        // is either silent throughout or never reaches zero
+        if (chance(0.2f)) {
+            opParams.level = 0.f;
+            opParams.levelCv = 0.f;
+        } else {
+            opParams.level = uniform(0.2f, 1.f);
+            opParams.levelCv = uniform(-1.f, 1.f) * (opParams.level - 0.1f);
+        }
+        opParams.pitch = integer(-12, 12);
+        opParams.pitchCv = uniform(-1.f, 1.f);
+        opParams.wave = smoothWaves ? uniform(0.f, 0.2f) : uniform(0.f, 1.f);
+        opParams.waveCv = smoothWaves ? uniform(-0.05f, 0.05f) : uniform(-1.f, 1.f);
+        opParams.feedback = (mode == DifferentialMode::BAND_LIMITED || frozen) ? 0.f : uniform(0.f, maxFeedback);
+
+        opParams.levelInput = uniform(-10.f, 10.f);
+        opParams.pitchInput = uniform(-10.f, 10.f);
+        opParams.waveInput = uniform(-10.f, 10.f);
+    }
+
+    // CV inputs are slow random sines around their starting voltage
+    std::array<std::array<float, 3>, OPERATOR_COUNT> cvRates;
+    for (auto& rates : cvRates) {
+        for (float& rate : rates) {
+            rate = varyingCv ? uniform(0.f, 20.f) * SAMPLE_TIME : 0.f;
+        }
+    }
+
+    testCase.params.resize(testCase.frames);
+    testCase.pitch.assign(testCase.frames * MAX_CHANNEL_COUNT, 0.f);
+
+    std::array<float, MAX_CHANNEL_COUNT> notes;
+    std::array<float, MAX_CHANNEL_COUNT> vibratoRates;
+    for (int c = 0; c < MAX_CHANNEL_COUNT; ++c) {
+        notes[c] = (mode == DifferentialMode::BAND_LIMITED) ? uniform(-1.f, 0.f) : uniform(-2.f, 2.f);
+        vibratoRates[c] = uniform(0.f, 8.f) * SAMPLE_TIME;
+    }
+
+    for (int frame = 0; frame < testCase.frames; ++frame) {
+        SpiderParams& params = testCase.params[frame];
+        params = base;
+        for (int op = 0; op < OPERATOR_COUNT; ++op) {
+            OperatorParams& opParams = params.operators[op];
+            opParams.levelInput *= std::cos(float(2 * M_PI) * cvRates[op][0] * frame);
+            opParams.pitchInput *= std::cos(float(2 * M_PI) * cvRates[op][1] * frame);
+            opParams.waveInput *= std::cos(float(2 * M_PI) * cvRates[op][2] * frame);
+        }
+
+        for (int c = 0; c < MAX_CHANNEL_COUNT; ++c) {
+            float vibrato = 0.02f * std::sin(float(2 * M_PI) * vibratoRates[c] * frame);
+            testCase.pitch[frame * MAX_CHANNEL_COUNT + c] = notes[c] + vibrato;
+        }
+    }
+
+    testCase.controlDivision = 1 << integer(2, 6);
+
+    for (int frame = 0; frame < testCase.frames;) {
+        int size = varyingCv ? 1 : std::min(integer(1, 256), testCase.frames - frame);
+        testCase.blockSizes.push_back(size);
+        frame += size;
+    }
+
+    return testCase;
+}
+
+// Renders testCase with the engine and the reference and returns the largest difference between them
+template <typename Generator>
+DifferentialResult compareWithReference(const DifferentialCase& testCase) {
+    RenderArgs args;
+    args.sampleRate = SAMPLES_PER_SECOND;
+    args.sampleTime = SAMPLE_TIME;
+
+    // The module's path from an edited graph to the schedule the audio thread runs
+    FixedDirectedGraph<OPERATOR_COUNT> fixedGraph;
+    for (int src = 0; src < OPERATOR_COUNT; ++src) {
+        for (int dest = 0; dest < OPERATOR_COUNT; ++dest) {
+            if (testCase.graph.hasEdge(src, dest)) {
+                fixedGraph.addEdge(src, dest);
+            }
+        }
+    }
+    for (const std::pair<int, int>& edge : testCase.loopEdges) {
+        fixedGraph.addEdge(edge.first, edge.second);
+    }
+    std::array<int, OPERATOR_COUNT> order;
+    fixedGraph.topologicalSort(order);
+
+    SpiderEngine engine;
+    engine.schedule.compile(fixedGraph, order);
+    engine.schedule.setCarriers(testCase.carriers);
+    engine.schedule.setDepths(testCase.depths);
+    engine.channels = testCase.channels;
+    engine.audioRateCv = testCase.mode == DifferentialMode::AUDIO_RATE ||
+                         testCase.mode == DifferentialMode::FROZEN_GENERATOR ||
+                         testCase.mode == DifferentialMode::FEEDBACK_LOOPS;
+    engine.controlDivision = testCase.controlDivision;
+    engine.bandLimited = testCase.mode == DifferentialMode::BAND_LIMITED;
+
+    // Around a loop the reference evaluates in the engine's order, which decides which edges are heard a sample late
+    ReferenceEngine<Generator> reference =
+        testCase.loopEdges.empty()
+            ? ReferenceEngine<Generator>(testCase.graph, testCase.carriers, testCase.depths, testCase.channels)
+            : ReferenceEngine<Generator>(testCase.graph, testCase.loopEdges,
+                                         std::vector<int>(order.begin(), order.end()), testCase.carriers,
+                                         testCase.depths, testCase.channels);
+
+    DifferentialResult result;
+    std::vector<float> engineOutput(testCase.frames * MAX_CHANNEL_COUNT);
+    int start = 0;
+    for (int frames : testCase.blockSizes) {
+        engine.renderBlock(args, testCase.params[start], frames, &testCase.pitch[start * MAX_CHANNEL_COUNT],
+                           &engineOutput[start * MAX_CHANNEL_COUNT]);
+        start += frames;
+
+        for (float freq : engine.freqs) {
+            result.finite &= std::isfinite(freq);
+        }
+    }
+
+    result.samples = long(testCase.frames) * testCase.channels;
+    float tolerance = differentialTolerance(testCase.mode);
+    std::array<float, MAX_CHANNEL_COUNT> referenceOutput;
+    for (int frame = 0; frame < testCase.frames; ++frame) {
+        reference.process(args, testCase.params[frame], &testCase.pitch[frame * MAX_CHANNEL_COUNT],
+                          referenceOutput.data());
+
+        for (int c = 0; c < testCase.channels; ++c) {
+            float error = std::abs(engineOutput[frame * MAX_CHANNEL_COUNT + c] - referenceOutput[c]);
+            // NaN counts as the largest possible error
+            if (!(error <= tolerance)) {
+                result.outliers++;
+            }
+            if (!(error <= result.error)) {
+                result.error = std::isnan(error) ? INFINITY : error;
+                result.frame = frame;
+                result.channel = c;
+            }
+        }
+    }
+    return result;
+}
+
+inline DifferentialResult runDifferential(const DifferentialCase& testCase) {
+    if (!morphWavetable.isGenerated()) {
+        morphWavetable.generate();
+    }
+
+    if (testCase.mode == DifferentialMode::FROZEN_GENERATOR) {
+        return compareWithReference<frozen::BranchingSignalGenerator>(testCase);
+    }
+    return compareWithReference<FixedPhaseSignalGenerator>(testCase);
+}
+
+} // namespace ph
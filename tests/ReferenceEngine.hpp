@@ -0,0 +1,145 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <utility>
+#include <vector>
+#include "../src/DirectedGraph.hpp"
+#include "../src/SignalGenerator.hpp"
+#include "../src/SpiderEngine.hpp"
+#include "BranchingSignalGenerator.hpp"
+
+namespace ph {
+
+// Frozen copy of Spider's original scalar operator loop, kept as the reference every optimised engine is checked
+// against (see Differential.hpp). One channel and one operator at a time, every operator every frame, params read
+// every frame. Do not optimise it.
+//
+// It is the loop from before block rendering with modulation depths added, and the modulators of an operator are
+// summed in ascending order as RoutingSchedule sums them so both round the same way. Around a loop an operator hears a
+// modulator that comes after it in the order from the previous sample, with the modulation scaled by the modulator's
+// unmodulated frequency. Generator is the scalar signal
+// generator to run: the frozen original by default, or FixedPhaseSignalGenerator to share the engine's generator and
+// check only the loop around it.
+template <typename Generator = frozen::BranchingSignalGenerator>
+struct ReferenceEngine {
+    // graph must be acyclic. depths[mod][op] scales the modulation of op by mod.
+    ReferenceEngine(const DirectedGraph<int>& graph, const std::array<bool, OPERATOR_COUNT>& carriers,
+                    const std::array<std::array<float, OPERATOR_COUNT>, OPERATOR_COUNT>& depths, int channels)
+        : ReferenceEngine(graph, {}, graph.topologicalSort(), carriers, depths, channels) {}
+
+    // Routing with loops. graph holds the edges DirectedGraph accepted and loopEdges the {src, dest} edges it refused
+    // for closing a cycle. order is the evaluation order of every operator.
+    ReferenceEngine(const DirectedGraph<int>& graph, const std::vector<std::pair<int, int>>& loopEdges,
+                    const std::vector<int>& order, const std::array<bool, OPERATOR_COUNT>& carriers,
+                    const std::array<std::array<float, OPERATOR_COUNT>, OPERATOR_COUNT>& depths, int channels)
+        : graph(graph)
+        , loopEdges(loopEdges)
+        , carriers(carriers)
+        , depths(depths)
+        , channels(channels)
+        , topologicalOrder(order) {}
+
+    bool hasEdge(int src, int dest) const {
+        return graph.hasEdge(src, dest) ||
+               std::find(loopEdges.begin(), loopEdges.end(), std::make_pair(src, dest)) != loopEdges.end();
+    }
+
+    // Renders one frame. pitch holds the 1V/Oct voltage of each channel and output receives the clamped carrier sum.
+    void process(const RenderArgs& args, const SpiderParams& params, const float* pitch, float* output) {
+        for (int op = 0; op < OPERATOR_COUNT; ++op) {
+            for (int c = 0; c < channels; c++) {
+                float freqParam = params.frequency / 12.f;
+                freqs[op][c] = dsp::FREQ_C4 * dsp::exp2_taylor5(freqParam + pitch[c]);
+            }
+        }
+
+        // What each operator's frequency will be before modulation, heard by the operators it is fed back to
+        for (int op = 0; op < OPERATOR_COUNT; ++op) {
+            const OperatorParams& opParams = params.operators[op];
+            for (int c = 0; c < channels; c++) {
+                float freq = freqs[op][c];
+                freq *= dsp::exp2_taylor5(opParams.pitch / 12.0f);
+                freq *= dsp::exp2_taylor5(opParams.pitchInput / 10.f * opParams.pitchCv);
+                unmodulatedFreqs[op][c] = freq;
+            }
+        }
+
+        evaluated.fill(false);
+        for (int op : topologicalOrder) {
+            processOperator(op, args, params.operators[op]);
+            evaluated[op] = true;
+        }
+
+        for (int c = 0; c < channels; c++) {
+            float sum = 0.f;
+            for (int op = 0; op < OPERATOR_COUNT; ++op) {
+                if (carriers[op]) {
+                    sum += outs[op][c];
+                }
+            }
+
+            if (sum > 1.f) {
+                sum = 1.f;
+            } else if (sum < -1.f) {
+                sum = -1.f;
+            }
+            output[c] = sum;
+        }
+    }
+
+    void processOperator(int op, const RenderArgs& args, const OperatorParams& opParams) {
+        float levelInput = opParams.levelInput / 10.f;
+        float level = opParams.level + (levelInput * opParams.levelCv);
+        level = clamp(level, 0.f, 1.f);
+
+        float pitchShiftInput = opParams.pitchInput / 10.f;
+        float octaveShift = opParams.pitch / 12.0f;
+
+        float wavePosInput = opParams.waveInput / 10.f;
+        float wavePos = opParams.wave + (opParams.waveCv * wavePosInput);
+        wavePos = clamp(wavePos, 0.f, 1.f);
+
+        for (int c = 0; c < channels; c++) {
+            float& freq = freqs[op][c];
+
+            freq *= dsp::exp2_taylor5(octaveShift);                        // +- 12 semitones coarse pitch
+            freq *= dsp::exp2_taylor5(pitchShiftInput * opParams.pitchCv); // +-12 semitones pitch shift
+
+            for (int mod = 0; mod < OPERATOR_COUNT; ++mod) {
+                if (hasEdge(mod, op)) {
+                    float modFreq = freqs[mod][c];
+                    if (!evaluated[mod]) {
+                        // Fed back, not yet evaluated this frame
+                        modFreq = unmodulatedFreqs[mod][c];
+                    }
+                    freq += 5.f * depths[mod][op] * modFreq * outs[mod][c];
+                }
+            }
+
+            // oldOuts was never written, so the feedback is half the last output
+            float avgOldSample = (outs[op][c] + oldOuts[op][c]) / 2;
+
+            float feedback = 5.f * opParams.feedback * avgOldSample;
+
+            outs[op][c] = level * generators[op][c].generate(args.sampleTime, freq, wavePos, feedback);
+        }
+    }
+
+    DirectedGraph<int> graph;
+    std::vector<std::pair<int, int>> loopEdges;
+    std::array<bool, OPERATOR_COUNT> carriers;
+    std::array<std::array<float, OPERATOR_COUNT>, OPERATOR_COUNT> depths;
+    int channels;
+    std::vector<int> topologicalOrder;
+
+    std::array<std::array<Generator, MAX_CHANNEL_COUNT>, OPERATOR_COUNT> generators;
+    std::array<std::array<float, MAX_CHANNEL_COUNT>, OPERATOR_COUNT> freqs = {};
+    std::array<std::array<float, MAX_CHANNEL_COUNT>, OPERATOR_COUNT> unmodulatedFreqs = {};
+    std::array<bool, OPERATOR_COUNT> evaluated = {};
+    std::array<std::array<float, MAX_CHANNEL_COUNT>, OPERATOR_COUNT> outs = {};
+    std::array<std::array<float, MAX_CHANNEL_COUNT>, OPERATOR_COUNT> oldOuts = {};
+};
+
+} // namespace ph
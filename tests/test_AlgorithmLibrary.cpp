@@ -0,0 +1,58 @@
+#include <catch2/catch_all.hpp>
+#include "../src/AlgorithmLibrary.hpp"
+#include "../src/FixedDirectedGraph.hpp"
+
+using namespace Catch;
+using namespace Catch::Matchers;
+using namespace Catch::Generators;
+
+namespace ph {
+
+TEST_CASE("Library algorithms run from the last operator down", "[AlgorithmLibrary]") {
+    for (const LibraryAlgorithm& algorithm : LIBRARY_ALGORITHMS) {
+        REQUIRE(algorithm.carriers != 0);
+
+        uint8_t modulating = 0;
+        for (int op = 0; op < 6; ++op) {
+            // Only higher operators modulate op
+            REQUIRE((algorithm.modulators[op] & ((2 << op) - 1)) == 0);
+            modulating |= algorithm.modulators[op];
+        }
+
+        // Every operator is heard, directly or through what it modulates
+        REQUIRE((algorithm.carriers | modulating) == 0x3f);
+    }
+}
+
+TEST_CASE("Library algorithms match the DX7 layouts", "[AlgorithmLibrary]") {
+    // Algorithm 1: 2 > 1 and 6 > 5 > 4 > 3
+    REQUIRE(LIBRARY_ALGORITHMS[0].modulators[0] == 0b000010);
+    REQUIRE(LIBRARY_ALGORITHMS[0].modulators[2] == 0b001000);
+    REQUIRE(LIBRARY_ALGORITHMS[0].modulators[3] == 0b010000);
+    REQUIRE(LIBRARY_ALGORITHMS[0].modulators[4] == 0b100000);
+    REQUIRE(LIBRARY_ALGORITHMS[0].carriers == 0b000101);
+
+    // Algorithm 16: 2, 3 and 5 all modulate 1
+    REQUIRE(LIBRARY_ALGORITHMS[15].modulators[0] == 0b010110);
+    REQUIRE(LIBRARY_ALGORITHMS[15].carriers == 0b000001);
+
+    // Algorithm 32: six carriers
+    REQUIRE(LIBRARY_ALGORITHMS[31].carriers == 0b111111);
+}
+
+TEST_CASE("Loading a library algorithm replaces the graph and carriers", "[AlgorithmLibrary]") {
+    FixedDirectedGraph<6> graph;
+    graph.addEdge(0, 5);
+    std::array<bool, 6> carriers = {false, false, false, false, false, true};
+
+    int index = GENERATE(range(0, LIBRARY_ALGORITHM_COUNT));
+    loadLibraryAlgorithm(index, graph, carriers);
+
+    const LibraryAlgorithm& algorithm = LIBRARY_ALGORITHMS[index];
+    for (int op = 0; op < 6; ++op) {
+        REQUIRE(carriers[op] == bool(algorithm.carriers & (1 << op)));
+        REQUIRE(graph.getPredecessors(op) == algorithm.modulators[op]);
+    }
+}
+
+} // namespace ph
@@ -0,0 +1,49 @@
+#include <catch2/catch_all.hpp>
+#include "Differential.hpp"
+
+using namespace Catch;
+using namespace Catch::Matchers;
+using namespace Catch::Generators;
+
+namespace ph {
+
+TEST_CASE("Engine matches the reference engine on random patches", "[Differential]") {
+    int mode = GENERATE(range(0, DIFFERENTIAL_MODE_COUNT));
+    uint64_t seed = GENERATE(range(0, 50));
+
+    DifferentialMode differentialMode = DifferentialMode(mode);
+    DifferentialCase testCase = randomDifferentialCase(seed, differentialMode);
+    DifferentialResult result = runDifferential(testCase);
+
+    INFO(differentialModeName(differentialMode) << ", seed " << seed << ", " << testCase.channels
+                                                << " channels: largest difference at frame " << result.frame
+                                                << " of channel " << result.channel << ", " << result.outliers
+                                                << " samples past the tolerance"
+                                                << (result.finite ? "" : ", non-finite frequency"));
+    REQUIRE(result.passed(differentialMode));
+}
+
+TEST_CASE("Reference engine matches the engine's phase arithmetic with a fixed phase generator", "[Differential]") {
+    // A single sine carrier, so the reference and engine share nothing but the generator and params
+    DirectedGraph<int> graph(OPERATOR_COUNT);
+    std::array<bool, OPERATOR_COUNT> carriers = {true, false, false, false, false, false};
+    std::array<std::array<float, OPERATOR_COUNT>, OPERATOR_COUNT> depths = {};
+    ReferenceEngine<FixedPhaseSignalGenerator> reference(graph, carriers, depths, 1);
+
+    SpiderParams params = {};
+    params.operators[0].level = 1.f;
+
+    RenderArgs args;
+    args.sampleRate = SAMPLES_PER_SECOND;
+    args.sampleTime = SAMPLE_TIME;
+
+    FixedPhaseSignalGenerator gen;
+    float pitch = 0.f;
+    for (int i = 0; i < 512; ++i) {
+        float output;
+        reference.process(args, params, &pitch, &output);
+        REQUIRE(output == gen.generate(SAMPLE_TIME, dsp::FREQ_C4, 0.f));
+    }
+}
+
+} // namespace ph
@@ -0,0 +1,199 @@
+#include <catch2/catch_all.hpp>
+#include "../src/FixedDirectedGraph.hpp"
+
+using namespace Catch;
+using namespace Catch::Matchers;
+using namespace Catch::Generators;
+
+namespace ph {
+
+TEST_CASE("Fixed graph starts with no edges", "[FixedDirectedGraph]") {
+    FixedDirectedGraph<6> graph;
+
+    for (int i = 0; i < 6; ++i) {
+        REQUIRE(graph.getSuccessors(i) == 0);
+        REQUIRE(graph.getPredecessors(i) == 0);
+    }
+}
+
+TEST_CASE("Adding an edge to a fixed graph updates both adjacency masks", "[FixedDirectedGraph]") {
+    FixedDirectedGraph<3> graph;
+    graph.addEdge(0, 1);
+    graph.addEdge(0, 2);
+    graph.addEdge(1, 2);
+
+    REQUIRE(graph.getSuccessors(0) == 0b110);
+    REQUIRE(graph.getSuccessors(1) == 0b100);
+    REQUIRE(graph.getSuccessors(2) == 0);
+
+    REQUIRE(graph.getPredecessors(0) == 0);
+    REQUIRE(graph.getPredecessors(1) == 0b001);
+    REQUIRE(graph.getPredecessors(2) == 0b011);
+
+    REQUIRE(graph.hasEdge(0, 1));
+    REQUIRE(graph.hasReverseEdge(1, 0));
+    REQUIRE_FALSE(graph.hasEdge(1, 0));
+}
+
+TEST_CASE("Fixed graph keeps its transitive closure up to date", "[FixedDirectedGraph]") {
+    FixedDirectedGraph<4> graph;
+    graph.addEdge(0, 1);
+    graph.addEdge(2, 3);
+
+    REQUIRE(graph.canReach(0, 1));
+    REQUIRE_FALSE(graph.canReach(0, 3));
+
+    graph.addEdge(1, 2);
+    REQUIRE(graph.canReach(0, 3));
+    REQUIRE(graph.canReach(1, 3));
+    REQUIRE_FALSE(graph.canReach(3, 0));
+
+    graph.removeEdge(1, 2);
+    REQUIRE_FALSE(graph.canReach(0, 3));
+    REQUIRE(graph.canReach(2, 3));
+}
+
+TEST_CASE("Removing an edge keeps other paths in the closure", "[FixedDirectedGraph]") {
+    FixedDirectedGraph<3> graph;
+    graph.addEdge(0, 1);
+    graph.addEdge(1, 2);
+    graph.addEdge(0, 2);
+
+    graph.removeEdge(0, 2);
+    REQUIRE(graph.canReach(0, 2));
+
+    graph.removeEdge(1, 2);
+    REQUIRE_FALSE(graph.canReach(0, 2));
+}
+
+TEST_CASE("Fixed graph allows cycles but not loops", "[FixedDirectedGraph]") {
+    FixedDirectedGraph<3> graph;
+    graph.addEdge(0, 1);
+    graph.addEdge(1, 2);
+
+    REQUIRE(graph.addEdge(2, 0));
+    REQUIRE_FALSE(graph.addEdge(1, 1));
+
+    REQUIRE(graph.hasEdge(2, 0));
+    REQUIRE_FALSE(graph.hasEdge(1, 1));
+    REQUIRE(graph.isCyclic());
+    REQUIRE(graph.canReach(1, 1));
+    REQUIRE(graph.getComponent(0) == 0b111);
+
+    graph.removeEdge(1, 2);
+    REQUIRE_FALSE(graph.isCyclic());
+    REQUIRE_FALSE(graph.canReach(1, 1));
+    REQUIRE(graph.getComponent(0) == 0b001);
+}
+
+TEST_CASE("Toggling an edge whose reverse exists in a fixed graph adds it", "[FixedDirectedGraph]") {
+    FixedDirectedGraph<6> graph;
+    graph.addEdge(2, 1);
+
+    REQUIRE(graph.toggleEdge(1, 2));
+    REQUIRE(graph.hasEdge(1, 2));
+    REQUIRE(graph.hasEdge(2, 1));
+    REQUIRE(graph.getComponent(1) == 0b000110);
+
+    REQUIRE_FALSE(graph.toggleEdge(1, 2));
+    REQUIRE(graph.hasEdge(2, 1));
+}
+
+TEST_CASE("Toggling edges in a fixed graph keeps its closure correct", "[FixedDirectedGraph]") {
+    FixedDirectedGraph<6> fixedGraph;
+    std::array<std::array<bool, 6>, 6> edges = {};
+
+    auto src = GENERATE(take(200, random(0, 5)));
+    auto dest = GENERATE(take(5, random(0, 5)));
+
+    // Build up a random graph, cycles included, and compare reachability with a search of the same edges
+    for (int i = 0; i < 30; ++i) {
+        int a = (src + i * 7) % 6;
+        int b = (dest + i * 5 + i / 6) % 6;
+        if (a == b) {
+            continue;
+        }
+
+        fixedGraph.toggleEdge(a, b);
+        edges[a][b] = !edges[a][b];
+
+        for (int u = 0; u < 6; ++u) {
+            std::array<bool, 6> reached = {};
+            std::vector<int> stack = {u};
+            while (!stack.empty()) {
+                int v = stack.back();
+                stack.pop_back();
+                for (int w = 0; w < 6; ++w) {
+                    if (edges[v][w] && !reached[w]) {
+                        reached[w] = true;
+                        stack.push_back(w);
+                    }
+                }
+            }
+
+            for (int v = 0; v < 6; ++v) {
+                REQUIRE(fixedGraph.hasEdge(u, v) == edges[u][v]);
+                REQUIRE(fixedGraph.canReach(u, v) == reached[v]);
+            }
+        }
+    }
+}
+
+TEST_CASE("Topological sort of a fixed graph orders every edge", "[FixedDirectedGraph]") {
+    FixedDirectedGraph<6> graph;
+
+    SECTION("No edges") {
+        REQUIRE(graph.topologicalSort() == std::vector<int>{0, 1, 2, 3, 4, 5});
+    }
+
+    SECTION("Chain in reverse vertex order") {
+        graph.addEdge(5, 4);
+        graph.addEdge(4, 3);
+        graph.addEdge(3, 2);
+        graph.addEdge(2, 1);
+        graph.addEdge(1, 0);
+
+        REQUIRE(graph.topologicalSort() == std::vector<int>{5, 4, 3, 2, 1, 0});
+    }
+
+    SECTION("Multiple correct orders") {
+        graph.addEdge(0, 2);
+        graph.addEdge(0, 3);
+        graph.addEdge(1, 3);
+        graph.addEdge(1, 4);
+        graph.addEdge(2, 5);
+        graph.addEdge(3, 5);
+        graph.addEdge(4, 5);
+
+        std::array<int, 6> order;
+        graph.topologicalSort(order);
+
+        std::array<int, 6> position;
+        for (int i = 0; i < 6; ++i) {
+            position[order[i]] = i;
+        }
+
+        for (int u = 0; u < 6; ++u) {
+            for (int v = 0; v < 6; ++v) {
+                if (graph.hasEdge(u, v)) {
+                    REQUIRE(position[u] < position[v]);
+                }
+            }
+        }
+    }
+
+    SECTION("Cycles are ordered as one component") {
+        // 3 <-> 1 -> 0 <- 2 <-> 4, with 5 feeding the first cycle
+        graph.addEdge(3, 1);
+        graph.addEdge(1, 3);
+        graph.addEdge(1, 0);
+        graph.addEdge(2, 0);
+        graph.addEdge(2, 4);
+        graph.addEdge(4, 2);
+        graph.addEdge(5, 3);
+
+        REQUIRE(graph.topologicalSort() == std::vector<int>{2, 4, 5, 1, 3, 0});
+    }
+}
+
+} // namespace ph
@@ -0,0 +1,75 @@
+#include <catch2/catch_all.hpp>
+#include "../src/FixedDirectedGraph.hpp"
+#include "../src/GraphJson.hpp"
+
+using namespace Catch;
+using namespace Catch::Matchers;
+using namespace Catch::Generators;
+
+namespace ph {
+
+TEST_CASE("Fixed graph round trips through JSON", "[GraphJson]") {
+    FixedDirectedGraph<6> graph;
+    graph.addEdge(1, 0);
+    graph.addEdge(2, 1);
+    graph.addEdge(5, 3);
+
+    json_t* graphJ = graphToJson(graph);
+
+    FixedDirectedGraph<6> loadedGraph;
+    loadedGraph.addEdge(4, 0);
+    graphFromJson(loadedGraph, graphJ);
+    json_decref(graphJ);
+
+    REQUIRE(loadedGraph == graph);
+    REQUIRE(loadedGraph.canReach(2, 0));
+}
+
+TEST_CASE("Fixed graph reads JSON written by the list graph", "[GraphJson]") {
+    DirectedGraph<int> listGraph(6);
+    listGraph.addEdge(3, 0);
+    listGraph.addEdge(1, 0);
+    listGraph.addEdge(4, 3);
+
+    json_t* graphJ = graphToJson(listGraph);
+
+    FixedDirectedGraph<6> graph;
+    graphFromJson(graph, graphJ);
+    json_decref(graphJ);
+
+    REQUIRE(graph.hasEdge(3, 0));
+    REQUIRE(graph.hasEdge(1, 0));
+    REQUIRE(graph.hasEdge(4, 3));
+    REQUIRE(graph.canReach(4, 0));
+}
+
+TEST_CASE("Graph JSON skips vertices and edges outside the graph", "[GraphJson]") {
+    // Destinations listed in the order the old list graph saved them, plus a vertex and edges that don't exist
+    json_t* graphJ = json_array();
+    std::vector<std::vector<int>> edges = {{}, {0}, {}, {0}, {3}, {}, {0}};
+    for (const auto& dests : edges) {
+        json_t* destsJ = json_array();
+        for (int dest : dests) {
+            json_array_append_new(destsJ, json_integer(dest));
+        }
+        json_array_append_new(graphJ, destsJ);
+    }
+    json_array_append_new(json_array_get(graphJ, 2), json_integer(6));
+    json_array_append_new(json_array_get(graphJ, 2), json_integer(-1));
+
+    DirectedGraph<int> listGraph(6);
+    graphFromJson(listGraph, graphJ);
+    FixedDirectedGraph<6> graph;
+    graphFromJson(graph, graphJ);
+    json_decref(graphJ);
+
+    for (int src = 0; src < 6; ++src) {
+        for (int dest = 0; dest < 6; ++dest) {
+            bool expected = (src == 1 || src == 3) ? dest == 0 : (src == 4 && dest == 3);
+            REQUIRE(graph.hasEdge(src, dest) == expected);
+            REQUIRE(listGraph.hasEdge(src, dest) == expected);
+        }
+    }
+}
+
+} // namespace ph
@@ -0,0 +1,108 @@
+#include <catch2/catch_all.hpp>
+#include "../src/HalfBandDecimator.hpp"
+
+using namespace rack;
+using namespace Catch;
+using namespace Catch::Matchers;
+using namespace Catch::Generators;
+
+namespace ph {
+
+// Amplitude of the output of a decimator fed a sine at `frequency` cycles per input sample, measured from its RMS
+// after the filter has settled
+template <typename Decimator>
+float decimatedAmplitude(Decimator& decimator, float frequency, int factor) {
+    double sumOfSquares = 0.0;
+    int count = 0;
+    std::array<float, 8> in;
+
+    for (int n = 0; n < 8192; ++n) {
+        for (int i = 0; i < factor; ++i) {
+            in[i] = std::sin(2.0 * M_PI * frequency * (double(n) * factor + i));
+        }
+
+        float out = decimator.process(in.data(), factor);
+        if (n >= 256) {
+            sumOfSquares += out * out;
+            count++;
+        }
+    }
+
+    return std::sqrt(2.0 * sumOfSquares / count);
+}
+
+TEST_CASE("Half-band decimator has unity gain at DC", "[HalfBandDecimator]") {
+    THalfBandDecimator<float, 10> decimator;
+
+    float out = 0.f;
+    for (int i = 0; i < 64; ++i) {
+        out = decimator.process(1.f, 1.f);
+    }
+
+    REQUIRE_THAT(out, WithinAbs(1.f, 0.00001));
+}
+
+TEST_CASE("Half-band decimator coefficients alternate in sign", "[HalfBandDecimator]") {
+    THalfBandDecimator<float, 10> decimator;
+
+    for (int j = 0; j < 10; ++j) {
+        REQUIRE((decimator.coefficients[j] > 0.f) == (j % 2 == 0));
+    }
+}
+
+TEST_CASE("Oversampling decimator passes the audio band and removes images above it", "[HalfBandDecimator]") {
+    int factor = GENERATE(2, 4, 8);
+
+    SECTION("Passband") {
+        // Up to 15kHz at a 48kHz output rate
+        float passbandFrequency = GENERATE(100.f, 2000.f, 15000.f);
+
+        TOversamplingDecimator<> decimator;
+        float frequency = passbandFrequency / (48000.f * factor);
+        REQUIRE_THAT(decimatedAmplitude(decimator, frequency, factor), WithinAbs(1.f, 0.01));
+    }
+
+    SECTION("Stopband") {
+        // Anything that would fold back below 18kHz at the output rate must be about 60dB down
+        float stopbandFrequency = GENERATE(30000.f, 40000.f, 100000.f, 170000.f);
+        if (stopbandFrequency >= 24000.f * factor) {
+            return;
+        }
+
+        TOversamplingDecimator<> decimator;
+        float frequency = stopbandFrequency / (48000.f * factor);
+        REQUIRE(decimatedAmplitude(decimator, frequency, factor) < 0.0012f);
+    }
+}
+
+TEST_CASE("Oversampling decimator with a factor of one passes the input through", "[HalfBandDecimator]") {
+    TOversamplingDecimator<> decimator;
+    float in = 0.25f;
+    REQUIRE(decimator.process(&in, 1) == 0.25f);
+}
+
+TEST_CASE("SIMD decimator matches the scalar decimator in every lane", "[HalfBandDecimator]") {
+    int factor = GENERATE(2, 4, 8);
+
+    TOversamplingDecimator<simd::float_4> simdDecimator;
+    std::array<TOversamplingDecimator<>, 4> decimators;
+
+    for (int n = 0; n < 512; ++n) {
+        simd::float_4 simdIn[8];
+        std::array<std::array<float, 8>, 4> in;
+
+        for (int i = 0; i < factor; ++i) {
+            for (int lane = 0; lane < 4; ++lane) {
+                in[lane][i] = std::sin(0.01f * (lane + 1) * (n * factor + i));
+                simdIn[i][lane] = in[lane][i];
+            }
+        }
+
+        simd::float_4 simdOut = simdDecimator.process(simdIn, factor);
+        for (int lane = 0; lane < 4; ++lane) {
+            REQUIRE_THAT(simdOut[lane], WithinAbs(decimators[lane].process(in[lane].data(), factor), 0.000001));
+        }
+    }
+}
+
+} // namespace ph
@@ -0,0 +1,63 @@
+#include <catch2/catch_all.hpp>
+#include "../src/LinearRamp.hpp"
+
+using namespace Catch;
+using namespace Catch::Matchers;
+using namespace Catch::Generators;
+
+namespace ph {
+
+TEST_CASE("Ramp with no frames jumps to its target", "[LinearRamp]") {
+    LinearRamp ramp;
+    ramp.setTarget(0.5f, 0);
+
+    REQUIRE_FALSE(ramp.isRamping());
+    REQUIRE(ramp.value == 0.5f);
+    REQUIRE(ramp.at(0) == 0.5f);
+}
+
+TEST_CASE("Ramp reaches its target after the given number of frames", "[LinearRamp]") {
+    int frames = GENERATE(1, 4, 16, 64);
+    float target = GENERATE(take(4, random(-10.f, 10.f)));
+
+    LinearRamp ramp;
+    ramp.setTarget(target, frames);
+
+    for (int frame = 0; frame < frames - 1; ++frame) {
+        REQUIRE(ramp.isRamping());
+        REQUIRE_THAT(ramp.at(frame), WithinAbs(target * (frame + 1) / frames, 0.0001));
+    }
+
+    // The last frame is exactly the target, not an accumulation of steps
+    REQUIRE(ramp.at(frames - 1) == target);
+    REQUIRE(ramp.at(frames + 10) == target);
+
+    ramp.advance(frames);
+    REQUIRE_FALSE(ramp.isRamping());
+    REQUIRE(ramp.value == target);
+}
+
+TEST_CASE("Ramp continues from where it was advanced to", "[LinearRamp]") {
+    LinearRamp ramp;
+    ramp.setTarget(1.f, 8);
+    ramp.advance(4);
+
+    REQUIRE(ramp.isRamping());
+    REQUIRE_THAT(ramp.value, WithinAbs(0.5f, 0.000001));
+    REQUIRE_THAT(ramp.at(0), WithinAbs(0.625f, 0.000001));
+
+    // Retargeting mid-ramp starts from the current value
+    ramp.setTarget(0.f, 2);
+    REQUIRE_THAT(ramp.at(0), WithinAbs(0.25f, 0.000001));
+    REQUIRE(ramp.at(1) == 0.f);
+}
+
+TEST_CASE("Ramp to the current value is not ramping", "[LinearRamp]") {
+    LinearRamp ramp;
+    ramp.setTarget(0.f, 16);
+
+    REQUIRE_FALSE(ramp.isRamping());
+    REQUIRE(ramp.at(0) == 0.f);
+}
+
+} // namespace ph
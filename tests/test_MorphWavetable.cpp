@@ -0,0 +1,131 @@
+#include "test_constants.hpp"
+#include <catch2/catch_all.hpp>
+#include "../src/MorphWavetable.hpp"
+#include "../src/SignalGenerator.hpp"
+
+using namespace Catch;
+using namespace Catch::Matchers;
+using namespace Catch::Generators;
+
+namespace ph {
+using Catch::Generators::random;
+
+const MorphWavetable& generatedWavetable() {
+    static MorphWavetable wavetable;
+    if (!wavetable.isGenerated()) {
+        wavetable.generate();
+    }
+    return wavetable;
+}
+
+TEST_CASE("Wavetable slices match the analytic waveforms away from their edges", "[MorphWavetable]") {
+    const MorphWavetable& wavetable = generatedWavetable();
+
+    int slice = GENERATE(0, 1, 2, 3, 4);
+    float wavePos = slice / 4.f;
+
+    // Keep away from the saw and square discontinuities where the band-limited versions ring
+    float phase = GENERATE(0.05f, 0.1f, 0.2f, 0.3f, 0.4f, 0.6f, 0.7f, 0.8f, 0.9f);
+
+    float expected = morphWave(phase, wavePos);
+    REQUIRE_THAT(wavetable.lookupLevel(phase, wavePos, 0), WithinAbs(expected, 0.01));
+}
+
+TEST_CASE("Wavetable morphs linearly between slices", "[MorphWavetable]") {
+    const MorphWavetable& wavetable = generatedWavetable();
+
+    int level = GENERATE(0, 4, 9);
+    float wavePos = GENERATE(take(10, random(0.f, 1.f)));
+    float phase = GENERATE(take(10, random(0.f, 1.f)));
+
+    float x = wavePos * 4.f;
+    int slice = std::min(int(x), 3);
+    float a = wavetable.lookupLevel(phase, slice / 4.f, level);
+    float b = wavetable.lookupLevel(phase, (slice + 1) / 4.f, level);
+
+    REQUIRE_THAT(wavetable.lookupLevel(phase, wavePos, level), WithinAbs(a + (x - slice) * (b - a), 0.00001));
+}
+
+TEST_CASE("Wavetable level has no harmonics above Nyquist", "[MorphWavetable]") {
+    float freq = GENERATE(20.f, 261.63f, 1000.f, 5000.f, 12000.f);
+    float increment = freq * SAMPLE_TIME;
+
+    int level = MorphWavetable::levelFor(increment);
+    int harmonics = MorphWavetable::MAX_HARMONICS >> level;
+
+    if (level < MorphWavetable::LEVELS - 1) {
+        REQUIRE(harmonics * freq <= SAMPLES_PER_SECOND / 2.f);
+    }
+
+    // The level below would alias
+    if (level > 0) {
+        REQUIRE(2 * harmonics * freq > SAMPLES_PER_SECOND / 2.f);
+    }
+
+    REQUIRE(MorphWavetable::levelFor(-increment) == level);
+}
+
+TEST_CASE("Top wavetable level is a pure fundamental", "[MorphWavetable]") {
+    const MorphWavetable& wavetable = generatedWavetable();
+
+    // The square's fundamental is 4/pi sin and the triangle's is -8/pi^2 cos
+    REQUIRE_THAT(wavetable.lookupLevel(0.25f, 0.75f, MorphWavetable::LEVELS - 1), WithinAbs(4.f / M_PI, 0.0001));
+    float triangleFundamental = -8.f / (M_PI * M_PI);
+    REQUIRE_THAT(wavetable.lookupLevel(0.f, 0.25f, MorphWavetable::LEVELS - 1), WithinAbs(triangleFundamental, 0.0001));
+}
+
+TEST_CASE("SIMD wavetable lookup matches scalar lookup", "[MorphWavetable]") {
+    const MorphWavetable& wavetable = generatedWavetable();
+
+    simd::float_4 phase = {0.1f, 0.45f, 0.7f, 0.99f};
+    simd::float_4 wavePos = {0.f, 0.3f, 0.6f, 1.f};
+    simd::float_4 increment = {0.001f, 0.01f, 0.1f, 0.3f};
+
+    simd::float_4 result = wavetable.lookup(phase, wavePos, increment);
+    for (int lane = 0; lane < 4; ++lane) {
+        REQUIRE(result[lane] == wavetable.lookup(phase[lane], wavePos[lane], increment[lane]));
+    }
+}
+
+TEST_CASE("Band-limited generator follows the analytic generator at low frequencies", "[MorphWavetable]") {
+    REQUIRE(morphWavetable.isGenerated());
+
+    float wavePos = GENERATE(0.f, 0.1f, 0.25f);
+    SpiderSignalGenerator analytic;
+    SpiderSignalGenerator bandLimited;
+
+    for (int i = 0; i < 1000; ++i) {
+        float expected = analytic.generate(SAMPLE_TIME, 100.f, wavePos);
+        REQUIRE_THAT(bandLimited.generateBandLimited(SAMPLE_TIME, 100.f, wavePos), WithinAbs(expected, 0.01));
+    }
+}
+
+TEST_CASE("Wavetable benchmark", "[.][benchmark]") {
+    std::vector<float> freqs(4096);
+    std::vector<float> wavePositions(4096);
+    for (size_t i = 0; i < freqs.size(); ++i) {
+        freqs[i] = 20.f + 2000.f * rack::random::uniform();
+        wavePositions[i] = rack::random::uniform();
+    }
+
+    BENCHMARK("Analytic SIMD generator, 4 voices") {
+        TSpiderSignalGenerator<simd::float_4> gen;
+        simd::float_4 sum = 0.f;
+        for (size_t i = 0; i < freqs.size(); i += 4) {
+            sum += gen.generate(SAMPLE_TIME, simd::float_4::load(&freqs[i]), simd::float_4::load(&wavePositions[i]));
+        }
+        return sum[0] + sum[1] + sum[2] + sum[3];
+    };
+
+    BENCHMARK("Band-limited SIMD generator, 4 voices") {
+        TSpiderSignalGenerator<simd::float_4> gen;
+        simd::float_4 sum = 0.f;
+        for (size_t i = 0; i < freqs.size(); i += 4) {
+            sum += gen.generateBandLimited(SAMPLE_TIME, simd::float_4::load(&freqs[i]),
+                                           simd::float_4::load(&wavePositions[i]));
+        }
+        return sum[0] + sum[1] + sum[2] + sum[3];
+    };
+}
+
+} // namespace ph
@@ -0,0 +1,273 @@
+#include <catch2/catch_all.hpp>
+#include "../src/RoutingSchedule.hpp"
+
+using namespace Catch;
+using namespace Catch::Matchers;
+using namespace Catch::Generators;
+
+namespace ph {
+
+TEST_CASE("Schedule of a graph with no edges has no modulators", "[RoutingSchedule]") {
+    DirectedGraph<int> graph(6);
+    RoutingSchedule<6> schedule;
+    schedule.compile(graph, graph.topologicalSort());
+
+    for (int i = 0; i < 6; ++i) {
+        REQUIRE(schedule.order[i] == i);
+        REQUIRE(schedule.modulatorCounts[i] == 0);
+    }
+}
+
+TEST_CASE("Schedule order is the topological order", "[RoutingSchedule]") {
+    DirectedGraph<int> graph(6);
+    graph.addEdge(5, 4);
+    graph.addEdge(4, 3);
+    graph.addEdge(3, 0);
+
+    auto order = graph.topologicalSort();
+
+    RoutingSchedule<6> schedule;
+    schedule.compile(graph, order);
+
+    REQUIRE(std::vector<int>(schedule.order.begin(), schedule.order.end()) == order);
+}
+
+TEST_CASE("Schedule modulator lists match the reverse adjacency lists", "[RoutingSchedule]") {
+    DirectedGraph<int> graph(6);
+    graph.addEdge(1, 0);
+    graph.addEdge(2, 0);
+    graph.addEdge(3, 0);
+    graph.addEdge(4, 3);
+    graph.addEdge(5, 3);
+
+    RoutingSchedule<6> schedule;
+    schedule.compile(graph, graph.topologicalSort());
+
+    for (int i = 0; i < 6; ++i) {
+        const auto& expected = graph.getAdjacentVerticesRev(i);
+        REQUIRE(schedule.modulatorCounts[i] == (int)expected.size());
+
+        std::vector<int> actual(schedule.modulators[i].begin(),
+                                schedule.modulators[i].begin() + schedule.modulatorCounts[i]);
+        REQUIRE(actual == expected);
+    }
+}
+
+TEST_CASE("Recompiling a schedule picks up removed edges", "[RoutingSchedule]") {
+    DirectedGraph<int> graph(6);
+    graph.addEdge(1, 0);
+    graph.addEdge(2, 0);
+
+    RoutingSchedule<6> schedule;
+    schedule.compile(graph, graph.topologicalSort());
+    REQUIRE(schedule.modulatorCounts[0] == 2);
+
+    graph.removeEdge(1, 0);
+    schedule.compile(graph, graph.topologicalSort());
+
+    REQUIRE(schedule.modulatorCounts[0] == 1);
+    REQUIRE(schedule.modulators[0][0] == 2);
+}
+
+TEST_CASE("Schedule lists carriers in operator order", "[RoutingSchedule]") {
+    RoutingSchedule<6> schedule;
+
+    schedule.setCarriers(std::array<bool, 6>{true, false, false, true, false, true});
+    REQUIRE(schedule.carrierCount == 3);
+    REQUIRE(schedule.carriers[0] == 0);
+    REQUIRE(schedule.carriers[1] == 3);
+    REQUIRE(schedule.carriers[2] == 5);
+
+    schedule.setCarriers(std::array<bool, 6>{});
+    REQUIRE(schedule.carrierCount == 0);
+}
+
+TEST_CASE("Schedule compiles from a fixed graph", "[RoutingSchedule]") {
+    FixedDirectedGraph<6> graph;
+    graph.addEdge(1, 0);
+    graph.addEdge(2, 0);
+    graph.addEdge(3, 2);
+
+    RoutingSchedule<6> schedule;
+    schedule.compile(graph, graph.topologicalSort());
+
+    REQUIRE(schedule.modulatorCounts[0] == 2);
+    REQUIRE(schedule.modulators[0][0] == 1);
+    REQUIRE(schedule.modulators[0][1] == 2);
+    REQUIRE(schedule.modulatorCounts[2] == 1);
+    REQUIRE(schedule.modulators[2][0] == 3);
+}
+
+TEST_CASE("Schedule modulation depths follow the modulator lists", "[RoutingSchedule]") {
+    FixedDirectedGraph<6> graph;
+    graph.addEdge(1, 0);
+    graph.addEdge(3, 0);
+    graph.addEdge(4, 3);
+
+    RoutingSchedule<6> schedule;
+    schedule.compile(graph, graph.topologicalSort());
+
+    REQUIRE(schedule.modulationDepths[0][0] == 1.f);
+    REQUIRE(schedule.modulationDepths[0][1] == 1.f);
+    REQUIRE(schedule.modulationDepths[3][0] == 1.f);
+
+    // Indexed [modulator][operator], depths of unconnected pairs are ignored
+    std::array<std::array<float, 6>, 6> depths = {};
+    depths[1][0] = 0.25f;
+    depths[3][0] = 1.5f;
+    depths[4][3] = 0.f;
+    depths[2][0] = 2.f;
+    schedule.setDepths(depths);
+
+    REQUIRE(schedule.modulationDepths[0][0] == 0.25f);
+    REQUIRE(schedule.modulationDepths[0][1] == 1.5f);
+    REQUIRE(schedule.modulationDepths[3][0] == 0.f);
+    REQUIRE(schedule.modulatorCounts[0] == 2);
+}
+
+TEST_CASE("Live operators are the carriers and everything that modulates them", "[RoutingSchedule]") {
+    FixedDirectedGraph<6> graph;
+    graph.addEdge(1, 0);
+    graph.addEdge(2, 1);
+    graph.addEdge(4, 3);
+
+    std::array<int, 6> order;
+    graph.topologicalSort(order);
+
+    RoutingSchedule<6> schedule;
+    schedule.compile(graph, order);
+    schedule.setCarriers(std::array<bool, 6>{true, false, false, false, false, false});
+
+    std::array<int, 6> liveOrder;
+
+    SECTION("Operators that can't reach a carrier are dead") {
+        int count = schedule.findLive(0, liveOrder);
+        REQUIRE(std::vector<int>(liveOrder.begin(), liveOrder.begin() + count) == std::vector<int>{2, 1, 0});
+    }
+
+    SECTION("A silent operator kills the modulators behind it") {
+        int count = schedule.findLive(0b000010, liveOrder);
+        REQUIRE(std::vector<int>(liveOrder.begin(), liveOrder.begin() + count) == std::vector<int>{0});
+    }
+
+    SECTION("A silent carrier kills everything") {
+        REQUIRE(schedule.findLive(0b000001, liveOrder) == 0);
+    }
+
+    SECTION("A modulator stays live while it reaches another live carrier") {
+        graph.addEdge(2, 3);
+        graph.topologicalSort(order);
+        schedule.compile(graph, order);
+        schedule.setCarriers(std::array<bool, 6>{true, false, false, true, false, false});
+
+        int count = schedule.findLive(0b000010, liveOrder);
+        std::vector<int> live(liveOrder.begin(), liveOrder.begin() + count);
+        std::sort(live.begin(), live.end());
+        REQUIRE(live == std::vector<int>{0, 2, 3, 4});
+    }
+}
+
+TEST_CASE("Operators fed back around a cycle are read a sample late", "[RoutingSchedule]") {
+    // 0 <- 1 <-> 2, and 3 -> 2
+    FixedDirectedGraph<6> graph;
+    graph.addEdge(1, 0);
+    graph.addEdge(1, 2);
+    graph.addEdge(2, 1);
+    graph.addEdge(3, 2);
+
+    std::array<int, 6> order;
+    graph.topologicalSort(order);
+    REQUIRE(order == std::array<int, 6>{3, 4, 5, 1, 2, 0});
+
+    RoutingSchedule<6> schedule;
+    schedule.compile(graph, order);
+    schedule.setCarriers(std::array<bool, 6>{true, false, false, false, false, false});
+    REQUIRE(schedule.cyclic);
+
+    // 1 reads 2 from the previous sample so 2 must not be evaluated before 1
+    REQUIRE(schedule.levels[1] == 0);
+    REQUIRE(schedule.levels[2] == 1);
+    REQUIRE(schedule.levels[0] == 1);
+
+    // Only the edge closing the cycle is fed back
+    REQUIRE(schedule.modulatorCounts[1] == 1);
+    REQUIRE(schedule.fedBack[1][0]);
+    for (int i = 0; i < schedule.modulatorCounts[2]; ++i) {
+        REQUIRE_FALSE(schedule.fedBack[2][i]);
+    }
+    REQUIRE_FALSE(schedule.fedBack[0][0]);
+
+    std::array<int, 6> liveOrder;
+
+    SECTION("Modulators fed back are live") {
+        int count = schedule.findLive(0, liveOrder);
+        REQUIRE(std::vector<int>(liveOrder.begin(), liveOrder.begin() + count) == std::vector<int>{3, 1, 2, 0});
+    }
+
+    SECTION("A silent operator in a cycle kills what only reaches the output through it") {
+        int count = schedule.findLive(0b000100, liveOrder);
+        REQUIRE(std::vector<int>(liveOrder.begin(), liveOrder.begin() + count) == std::vector<int>{1, 0});
+    }
+
+    SECTION("Removing the feedback leaves an acyclic schedule") {
+        graph.removeEdge(2, 1);
+        graph.topologicalSort(order);
+        schedule.compile(graph, order);
+        REQUIRE_FALSE(schedule.cyclic);
+    }
+}
+
+TEST_CASE("Wavefronts group operators whose modulators are all on earlier levels", "[RoutingSchedule]") {
+    FixedDirectedGraph<6> graph;
+    graph.addEdge(1, 0);
+    graph.addEdge(2, 0);
+    graph.addEdge(3, 1);
+
+    std::array<int, 6> order;
+    graph.topologicalSort(order);
+
+    RoutingSchedule<6> schedule;
+    schedule.compile(graph, order);
+
+    REQUIRE(schedule.levels == std::array<int, 6>{2, 1, 0, 0, 0, 0});
+
+    WavefrontPlan<6> plan;
+
+    SECTION("Each level starts a new vector") {
+        plan.build(schedule, order, 6);
+        REQUIRE(plan.vectorCount == 3);
+
+        // Level 0 has four operators and fills the first vector
+        REQUIRE(plan.laneCounts[0] == 4);
+        std::vector<int> first(plan.lanes[0].begin(), plan.lanes[0].end());
+        std::sort(first.begin(), first.end());
+        REQUIRE(first == std::vector<int>{2, 3, 4, 5});
+
+        REQUIRE(plan.laneCounts[1] == 1);
+        REQUIRE(plan.lanes[1][0] == 1);
+        REQUIRE(plan.laneCounts[2] == 1);
+        REQUIRE(plan.lanes[2][0] == 0);
+    }
+
+    SECTION("Only the given operators are placed") {
+        std::array<int, 6> live = {3, 1, 0};
+        plan.build(schedule, live, 3);
+        REQUIRE(plan.vectorCount == 3);
+        REQUIRE(plan.lanes[0][0] == 3);
+        REQUIRE(plan.lanes[1][0] == 1);
+        REQUIRE(plan.lanes[2][0] == 0);
+    }
+
+    SECTION("Wide levels spill into another vector") {
+        FixedDirectedGraph<6> flat;
+        flat.topologicalSort(order);
+        schedule.compile(flat, order);
+
+        plan.build(schedule, order, 6);
+        REQUIRE(plan.vectorCount == 2);
+        REQUIRE(plan.laneCounts[0] == 4);
+        REQUIRE(plan.laneCounts[1] == 2);
+    }
+}
+
+} // namespace ph
@@ -0,0 +1,102 @@
+#include <catch2/catch_all.hpp>
+#include "../src/ScheduleCache.hpp"
+
+using namespace Catch;
+using namespace Catch::Matchers;
+using namespace Catch::Generators;
+
+namespace ph {
+
+TEST_CASE("Schedule cache keys pack the off-diagonal edges and carriers", "[ScheduleCache]") {
+    FixedDirectedGraph<6> graph;
+    std::array<bool, 6> carriers = {};
+
+    REQUIRE(ScheduleCache<6>::key(graph, carriers) == 0);
+
+    // 0 -> 1 is the first off-diagonal bit, 5 -> 4 the last
+    graph.addEdge(0, 1);
+    REQUIRE(ScheduleCache<6>::key(graph, carriers) == 1);
+    graph.addEdge(5, 4);
+    REQUIRE(ScheduleCache<6>::key(graph, carriers) == (1 | (1ull << 29)));
+
+    carriers[0] = true;
+    carriers[5] = true;
+    REQUIRE(ScheduleCache<6>::key(graph, carriers) == (1 | (1ull << 29) | (1ull << 30) | (1ull << 35)));
+}
+
+TEST_CASE("Schedule cache returns what was inserted", "[ScheduleCache]") {
+    ScheduleCache<6, 2> cache;
+    REQUIRE(cache.find(42) == nullptr);
+    REQUIRE_FALSE(cache.contains(42));
+
+    RoutingSchedule<6> schedule;
+    schedule.carrierCount = 3;
+    cache.insert(42, schedule);
+
+    REQUIRE(cache.contains(42));
+    const RoutingSchedule<6>* cached = cache.find(42);
+    REQUIRE(cached != nullptr);
+    REQUIRE(cached->carrierCount == 3);
+
+    REQUIRE(cache.hits == 1);
+    REQUIRE(cache.misses == 1);
+    REQUIRE(cache.hitRate() == 0.5f);
+}
+
+TEST_CASE("Schedule cache evicts the least recently used schedule", "[ScheduleCache]") {
+    ScheduleCache<6, 2> cache;
+    RoutingSchedule<6> schedule;
+
+    cache.insert(1, schedule);
+    cache.insert(2, schedule);
+
+    // Using 1 makes 2 the oldest
+    cache.find(1);
+    cache.insert(3, schedule);
+
+    REQUIRE(cache.contains(1));
+    REQUIRE_FALSE(cache.contains(2));
+    REQUIRE(cache.contains(3));
+
+    // Inserting an existing key replaces it rather than taking another slot
+    schedule.carrierCount = 5;
+    cache.insert(1, schedule);
+    REQUIRE(cache.contains(3));
+    REQUIRE(cache.find(1)->carrierCount == 5);
+
+    cache.clear();
+    REQUIRE_FALSE(cache.contains(1));
+    REQUIRE(cache.hitRate() == 0.f);
+}
+
+TEST_CASE("Schedule cache benchmark", "[.][benchmark][ScheduleCache]") {
+    FixedDirectedGraph<6> graph;
+    graph.addEdge(1, 0);
+    graph.addEdge(2, 1);
+    graph.addEdge(3, 0);
+    graph.addEdge(5, 4);
+    std::array<bool, 6> carriers = {true, false, false, false, true, false};
+
+    std::array<int, 6> order;
+    RoutingSchedule<6> schedule;
+
+    BENCHMARK("Sort and compile") {
+        graph.topologicalSort(order);
+        schedule.compile(graph, order);
+        schedule.setCarriers(carriers);
+        return schedule.carrierCount;
+    };
+
+    ScheduleCache<6> cache;
+    for (int i = 0; i < 7; ++i) {
+        cache.insert(1000 + i, schedule);
+    }
+    cache.insert(ScheduleCache<6>::key(graph, carriers), schedule);
+
+    BENCHMARK("Cache lookup") {
+        schedule = *cache.find(ScheduleCache<6>::key(graph, carriers));
+        return schedule.carrierCount;
+    };
+}
+
+} // namespace ph
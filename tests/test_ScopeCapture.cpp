@@ -0,0 +1,101 @@
+#include <catch2/catch_all.hpp>
+#include "../src/ScopeCapture.hpp"
+
+using namespace Catch;
+using namespace Catch::Matchers;
+using namespace Catch::Generators;
+
+namespace ph {
+
+TEST_CASE("Scope history is empty until points are read", "[ScopeCapture]") {
+    ScopeCapture<8> scope;
+    scope.push(1.f);
+
+    for (size_t i = 0; i < 8; ++i) {
+        REQUIRE(scope.point(i) == 0.f);
+    }
+
+    REQUIRE(scope.update());
+    REQUIRE(scope.point(7) == 1.f);
+    REQUIRE_FALSE(scope.update());
+}
+
+TEST_CASE("Scope history is ordered oldest to newest", "[ScopeCapture]") {
+    ScopeCapture<8> scope;
+
+    for (int i = 1; i <= 11; ++i) {
+        scope.push(float(i));
+        scope.update();
+    }
+
+    for (size_t i = 0; i < 8; ++i) {
+        REQUIRE(scope.point(i) == float(i + 4));
+    }
+}
+
+TEST_CASE("Scope drops points when the reader falls behind", "[ScopeCapture]") {
+    ScopeCapture<8> scope;
+
+    for (int i = 1; i <= 20; ++i) {
+        scope.push(float(i));
+    }
+    scope.update();
+
+    // The first points are kept and the rest are dropped until there is space again
+    for (size_t i = 0; i < 8; ++i) {
+        REQUIRE(scope.point(i) == float(i + 1));
+    }
+}
+
+TEST_CASE("Clearing a scope empties the queue and history", "[ScopeCapture]") {
+    ScopeCapture<8> scope;
+    scope.push(1.f);
+    scope.update();
+    scope.push(2.f);
+
+    scope.clear();
+
+    REQUIRE_FALSE(scope.update());
+    for (size_t i = 0; i < 8; ++i) {
+        REQUIRE(scope.point(i) == 0.f);
+    }
+}
+
+TEST_CASE("Scope envelope holds the range of each column", "[ScopeCapture]") {
+    ScopeCapture<16> scope;
+    for (int i = 0; i < 16; ++i) {
+        scope.push(float(i));
+    }
+    scope.update();
+
+    ScopeEnvelope<4> envelope;
+    envelope.update(scope);
+
+    for (size_t column = 0; column < 4; ++column) {
+        REQUIRE(envelope.minimums[column] == float(column * 4));
+        REQUIRE(envelope.maximums[column] == float(column * 4 + 3));
+    }
+}
+
+TEST_CASE("Scope envelope covers every point when columns don't divide the history", "[ScopeCapture]") {
+    ScopeCapture<512> scope;
+    for (int i = 0; i < 512; ++i) {
+        scope.push(std::sin(i * 0.3f));
+    }
+    scope.update();
+
+    ScopeEnvelope<48> envelope;
+    envelope.update(scope);
+
+    for (size_t i = 0; i < 512; ++i) {
+        size_t column = i * 48 / 512;
+        REQUIRE(scope.point(i) >= envelope.minimums[column]);
+        REQUIRE(scope.point(i) <= envelope.maximums[column]);
+    }
+
+    for (size_t column = 0; column < 48; ++column) {
+        REQUIRE(envelope.minimums[column] <= envelope.maximums[column]);
+    }
+}
+
+} // namespace ph
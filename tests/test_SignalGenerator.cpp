@@ -1,6 +1,7 @@
 #include "test_constants.hpp"
 #include <catch2/catch_all.hpp>
 #include "../src/SignalGenerator.hpp"
+#include "BranchingSignalGenerator.hpp"
 
 using namespace Catch;
 using namespace Catch::Matchers;
@@ -8,6 +9,10 @@ using namespace Catch::Generators;
 
 namespace ph {
 
+// The four-way branching generator that morphWave replaced, on the engine's sine so the two differ only in how they
+// blend
+typedef frozen::TBranchingSignalGenerator<DefaultSineBackend> BranchingSignalGenerator;
+
 class SignalGeneratorFixture {
 public:
     SpiderSignalGenerator gen;
@@ -30,11 +35,9 @@ public:
     }
 
     float incrementExpPhase(float phase, float freq) {
+        // Wrap fully, at high frequencies the phase advances by more than one cycle per sample
         phase += SAMPLE_TIME * freq;
-        if (phase > 1.f)
-            phase -= 1.f;
-        if (phase < -1.f)
-            phase += 1.f;
+        phase -= std::floor(phase);
 
         return phase;
     }
@@ -56,8 +59,8 @@ public:
     }
 };
 
-TEST_CASE_METHOD(SignalGeneratorFixture, "Sin LUT is initialised", "[SignalGenerator]") {
-    REQUIRE_FALSE(ph::sinTable.empty());
+TEST_CASE_METHOD(SignalGeneratorFixture, "Sine backend is ready before use", "[SignalGenerator]") {
+    REQUIRE_THAT(sin2pi(0.25f), WithinAbs(1.f, 0.000001));
 }
 
 TEST_CASE_METHOD(SignalGeneratorFixture, "Sin LUT is within 1e-3 of sin(2pi * x) for 48000 samples",
@@ -122,7 +125,7 @@ TEST_CASE_METHOD(SignalGeneratorFixture, "Signal generator blends sin and triang
     const float freq = 440.f;
     for (int i = 0; i < 512; ++i) {
         expPhase = incrementExpPhase(expPhase, freq);
-        float expected = crossfade(sin2pi(normalisePhase(expPhase)), triangle(expPhase), 0.5f);
+        float expected = rack::crossfade(sin2pi(normalisePhase(expPhase)), triangle(expPhase), 0.5f);
         float sample = gen.generate(SAMPLE_TIME, freq, 0.125f);
         REQUIRE_THAT(sample, WithinAbs(expected, 0.000001));
     }
@@ -133,7 +136,7 @@ TEST_CASE_METHOD(SignalGeneratorFixture, "Signal generator blends triangle and s
     const float freq = 440.f;
     for (int i = 0; i < 512; ++i) {
         expPhase = incrementExpPhase(expPhase, freq);
-        float expected = crossfade(triangle(expPhase), saw(expPhase), 0.5f);
+        float expected = rack::crossfade(triangle(expPhase), saw(expPhase), 0.5f);
         float sample = gen.generate(SAMPLE_TIME, freq, 0.375);
         REQUIRE_THAT(sample, WithinAbs(expected, 0.000001));
     }
@@ -144,7 +147,7 @@ TEST_CASE_METHOD(SignalGeneratorFixture, "Signal generator blends saw and square
     const float freq = 440.f;
     for (int i = 0; i < 512; ++i) {
         expPhase = incrementExpPhase(expPhase, freq);
-        float expected = crossfade(saw(expPhase), square(expPhase), 0.5f);
+        float expected = rack::crossfade(saw(expPhase), square(expPhase), 0.5f);
         float sample = gen.generate(SAMPLE_TIME, freq, 0.625);
         REQUIRE_THAT(sample, WithinAbs(expected, 0.000001));
     }
@@ -155,7 +158,7 @@ TEST_CASE_METHOD(SignalGeneratorFixture, "Signal generator blends square and sin
     const float freq = 440.f;
     for (int i = 0; i < 512; ++i) {
         expPhase = incrementExpPhase(expPhase, freq);
-        float expected = crossfade(square(expPhase), sin2pi(normalisePhase(expPhase)), 0.5f);
+        float expected = rack::crossfade(square(expPhase), sin2pi(normalisePhase(expPhase)), 0.5f);
         float sample = gen.generate(SAMPLE_TIME, freq, 0.875);
         REQUIRE_THAT(sample, WithinAbs(expected, 0.000001));
     }
@@ -204,4 +207,161 @@ TEST_CASE_METHOD(SignalGeneratorFixture, "Signal generator handles different sam
     }
 }
 
-} // namespace ph
\ No newline at end of file
+TEST_CASE_METHOD(SignalGeneratorFixture, "SIMD signal generator matches the scalar generator on every lane",
+                 "[SignalGenerator]") {
+    float wavePos = GENERATE(0.f, 0.125f, 0.25f, 0.375f, 0.5f, 0.625f, 0.75f, 0.875f, 1.f);
+
+    TSpiderSignalGenerator<simd::float_4> simdGen;
+    std::array<SpiderSignalGenerator, 4> scalarGens;
+
+    const float freqs[4] = {dsp::FREQ_C4, 440.f, -300.f, 18000.f};
+
+    for (int i = 0; i < 512; ++i) {
+        float phaseMod = 3.f * std::sin(i * 0.01f);
+        simd::float_4 sample = simdGen.generate(SAMPLE_TIME, simd::float_4::load(freqs), wavePos, phaseMod);
+
+        for (int lane = 0; lane < 4; ++lane) {
+            float expected = scalarGens[lane].generate(SAMPLE_TIME, freqs[lane], wavePos, phaseMod);
+            REQUIRE_THAT(sample[lane], WithinAbs(expected, 0.000001));
+        }
+    }
+}
+
+TEST_CASE_METHOD(SignalGeneratorFixture, "SIMD sin LUT matches the scalar sin LUT", "[SignalGenerator]") {
+    for (int i = 0; i < 1024; i += 4) {
+        simd::float_4 x(i / 1024.f, (i + 1) / 1024.f, (i + 2) / 1024.f, (i + 3) / 1024.f);
+        simd::float_4 y = sin2pi(x);
+
+        for (int lane = 0; lane < 4; ++lane) {
+            REQUIRE(y[lane] == sin2pi(x[lane]));
+        }
+    }
+}
+
+TEST_CASE("Fixed phase generator matches the float generator", "[SignalGenerator]") {
+    float wavePos = GENERATE(0.f, 0.125f, 0.375f, 0.625f, 0.875f, 1.f);
+
+    SpiderSignalGenerator floatGen;
+    FixedPhaseSignalGenerator fixedGen;
+
+    for (int i = 0; i < 512; ++i) {
+        float phaseMod = 3.f * std::sin(i * 0.01f);
+        float expected = floatGen.generate(SAMPLE_TIME, 440.f, wavePos, phaseMod);
+        float sample = fixedGen.generate(SAMPLE_TIME, 440.f, wavePos, phaseMod);
+
+        // The phases differ by float rounding, which only shows near the square and saw edges
+        if (std::abs(expected - sample) > 0.001f) {
+            REQUIRE(std::abs(floatGen.phase + phaseMod / float(2 * M_PI) - std::round(floatGen.phase)) < 0.0001f);
+            continue;
+        }
+        REQUIRE_THAT(sample, WithinAbs(expected, 0.0001));
+    }
+}
+
+TEST_CASE("Fixed phase generator advances by the same step forever", "[SignalGenerator]") {
+    FixedPhaseSignalGenerator gen;
+    const float freq = 440.f;
+    const uint32_t step = toFixedPhase(freq * SAMPLE_TIME);
+
+    for (int i = 0; i < 10 * SAMPLES_PER_SECOND; ++i) {
+        gen.generate(SAMPLE_TIME, freq, 0.f);
+    }
+
+    REQUIRE(gen.phase == uint32_t(10u * SAMPLES_PER_SECOND * step));
+}
+
+TEST_CASE("SIMD fixed phase generator matches the scalar generator on every lane", "[SignalGenerator]") {
+    float wavePos = GENERATE(0.f, 0.25f, 0.5f, 0.75f, 1.f);
+
+    TFixedPhaseSignalGenerator<simd::float_4> simdGen;
+    std::array<FixedPhaseSignalGenerator, 4> scalarGens;
+
+    const float freqs[4] = {dsp::FREQ_C4, 440.f, -300.f, 18000.f};
+
+    for (int i = 0; i < 512; ++i) {
+        float phaseMod = 3.f * std::sin(i * 0.01f);
+        simd::float_4 sample = simdGen.generate(SAMPLE_TIME, simd::float_4::load(freqs), wavePos, phaseMod);
+
+        for (int lane = 0; lane < 4; ++lane) {
+            REQUIRE(sample[lane] == scalarGens[lane].generate(SAMPLE_TIME, freqs[lane], wavePos, phaseMod));
+        }
+    }
+}
+
+TEST_CASE("Morph kernel matches the four-way crossfade", "[SignalGenerator]") {
+    float wavePos = GENERATE(take(64, Catch::Generators::random(0.f, 1.f)));
+
+    for (int i = 0; i < 1024; ++i) {
+        // stay clear of the square wave edges where a rounding difference flips the sign
+        float phase = (i + 0.5f) / 1024.f;
+
+        BranchingSignalGenerator branching;
+        branching.phase = phase;
+        float expected = branching.generate(SAMPLE_TIME, 0.f, wavePos);
+
+        REQUIRE_THAT(morphWave(phase, wavePos), WithinAbs(expected, 0.000001));
+    }
+}
+
+TEST_CASE("SIMD morph kernel morphs each lane independently", "[SignalGenerator]") {
+    simd::float_4 wavePos(0.1f, 0.4f, 0.6f, 0.9f);
+
+    for (int i = 0; i < 1024; ++i) {
+        float phase = (i + 0.5f) / 1024.f;
+        simd::float_4 sample = morphWave(simd::float_4(phase), wavePos);
+
+        for (int lane = 0; lane < 4; ++lane) {
+            REQUIRE_THAT(sample[lane], WithinAbs(morphWave(phase, wavePos[lane]), 0.000001));
+        }
+    }
+}
+
+TEST_CASE("Morph kernel benchmark", "[.][benchmark][SignalGenerator]") {
+    // A new wave position every sample is the worst case for the branching generator
+    std::vector<float> wavePositions(4096);
+    std::vector<float> freqs(4096);
+    for (size_t i = 0; i < wavePositions.size(); ++i) {
+        wavePositions[i] = rack::random::uniform();
+        freqs[i] = 20.f + 2000.f * rack::random::uniform();
+    }
+
+    BENCHMARK("Four-way branching generator") {
+        BranchingSignalGenerator gen;
+        float sum = 0.f;
+        for (size_t i = 0; i < wavePositions.size(); ++i) {
+            sum += gen.generate(SAMPLE_TIME, freqs[i], wavePositions[i], 0.1f);
+        }
+        return sum;
+    };
+
+    BENCHMARK("Branchless generator") {
+        SpiderSignalGenerator gen;
+        float sum = 0.f;
+        for (size_t i = 0; i < wavePositions.size(); ++i) {
+            sum += gen.generate(SAMPLE_TIME, freqs[i], wavePositions[i], 0.1f);
+        }
+        return sum;
+    };
+
+    BENCHMARK("Branchless SIMD generator, 4 voices") {
+        TSpiderSignalGenerator<simd::float_4> gen;
+        simd::float_4 sum = 0.f;
+        for (size_t i = 0; i < wavePositions.size(); i += 4) {
+            sum += gen.generate(SAMPLE_TIME, simd::float_4::load(&freqs[i]), simd::float_4::load(&wavePositions[i]),
+                                0.1f);
+        }
+        return sum[0] + sum[1] + sum[2] + sum[3];
+    };
+
+    BENCHMARK("Fixed phase SIMD generator, 4 voices") {
+        TFixedPhaseSignalGenerator<simd::float_4> gen;
+        simd::float_4 sum = 0.f;
+        for (size_t i = 0; i < wavePositions.size(); i += 4) {
+            sum += gen.generate(SAMPLE_TIME, simd::float_4::load(&freqs[i]), simd::float_4::load(&wavePositions[i]),
+                                0.1f);
+        }
+        return sum[0] + sum[1] + sum[2] + sum[3];
+    };
+}
+
+} // namespace ph
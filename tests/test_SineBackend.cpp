@@ -0,0 +1,153 @@
+#include "test_constants.hpp"
+#include <catch2/catch_all.hpp>
+#include "../src/SineBackend.hpp"
+
+using namespace Catch;
+using namespace Catch::Matchers;
+using namespace Catch::Generators;
+
+namespace ph {
+
+// Total harmonic distortion plus noise of a backend in dB, for a full scale sine at an exact DFT bin so there is no
+// window leakage. Everything that isn't the fundamental counts as distortion.
+template <typename Sine>
+double thdPlusNoise(int length = 8192, int bin = 317) {
+    double total = 0.0;
+    double re = 0.0;
+    double im = 0.0;
+
+    for (int n = 0; n < length; ++n) {
+        // Phase computed exactly so only the backend contributes
+        float phase = float((int64_t(n) * bin) % length) / length;
+        double y = Sine::sin2pi(phase);
+
+        total += y * y;
+        re += y * std::cos(2.0 * M_PI * bin * n / length);
+        im += y * std::sin(2.0 * M_PI * bin * n / length);
+    }
+
+    double fundamental = 2.0 * (re * re + im * im) / length;
+    return 10.0 * std::log10((total - fundamental) / fundamental);
+}
+
+TEMPLATE_TEST_CASE("Sine backends are close to std::sin for any phase", "[SineBackend]", LinearSineTable<256>,
+                   LinearSineTable<4096>, CubicSineTable<256>, CubicSineTable<1024>, MinimaxSine) {
+    // Whole cycles, negative phases and phases outside [0, 1) used to be clamped to the end of the table
+    for (float x : {0.f, 0.25f, 0.5f, 0.75f, 1.f, -1.f, 2.f, -0.25f, 1.25f, 100.75f, -0.9999999f}) {
+        REQUIRE_THAT(TestType::sin2pi(x), WithinAbs(std::sin(2.0 * M_PI * x), 1e-4));
+    }
+
+    for (int i = -4800; i <= 4800; ++i) {
+        float x = i / 1600.f;
+        REQUIRE_THAT(TestType::sin2pi(x), WithinAbs(std::sin(2.0 * M_PI * x), 1e-4));
+    }
+}
+
+TEMPLATE_TEST_CASE("SIMD sine backends match the scalar backends on every lane", "[SineBackend]",
+                   LinearSineTable<256>, LinearSineTable<4096>, CubicSineTable<256>, CubicSineTable<1024>,
+                   MinimaxSine) {
+    auto offset = GENERATE(-2.f, 0.f, 3.f);
+
+    for (int i = 0; i < 1024; i += 4) {
+        simd::float_4 x(i / 1024.f, (i + 1) / 1024.f, (i + 2) / 1024.f, (i + 3) / 1024.f);
+        x += offset;
+        simd::float_4 y = TestType::sin2pi(x);
+
+        for (int lane = 0; lane < 4; ++lane) {
+            REQUIRE(y[lane] == TestType::sin2pi(x[lane]));
+        }
+    }
+}
+
+TEST_CASE("Fixed point phases wrap to one cycle", "[SineBackend]") {
+    REQUIRE(toFixedPhase(0.f) == 0u);
+    REQUIRE(toFixedPhase(0.25f) == 0x40000000u);
+    REQUIRE(toFixedPhase(0.5f) == 0x80000000u);
+    REQUIRE(toFixedPhase(-0.25f) == 0xc0000000u);
+    REQUIRE(toFixedPhase(1.f) == 0u);
+    REQUIRE(toFixedPhase(3.75f) == 0xc0000000u);
+
+    for (int i = -1000; i <= 1000; ++i) {
+        float x = i / 317.f;
+        REQUIRE_THAT(fromFixedPhase(toFixedPhase(x)), WithinAbs(x - std::floor(x), 1e-6));
+    }
+}
+
+TEST_CASE("SIMD fixed point phases match the scalar conversion on every lane", "[SineBackend]") {
+    for (int i = -1000; i <= 1000; i += 4) {
+        simd::float_4 x(i / 317.f, (i + 1) / 317.f, (i + 2) / 317.f, (i + 3) / 317.f);
+        simd::int32_4 phase = toFixedPhase(x);
+        simd::float_4 cycles = fromFixedPhase(phase);
+
+        for (int lane = 0; lane < 4; ++lane) {
+            REQUIRE(uint32_t(phase[lane]) == toFixedPhase(x[lane]));
+            REQUIRE(cycles[lane] == fromFixedPhase(toFixedPhase(x[lane])));
+        }
+    }
+}
+
+TEMPLATE_TEST_CASE("Sine backends read fixed point phases", "[SineBackend]", LinearSineTable<256>,
+                   LinearSineTable<4096>, CubicSineTable<256>, CubicSineTable<1024>, MinimaxSine) {
+    for (int i = 0; i < 4096; i += 4) {
+        uint32_t phases[4];
+        for (int lane = 0; lane < 4; ++lane) {
+            phases[lane] = uint32_t(i + lane) * 1048573u;
+        }
+        simd::int32_4 simdPhase(phases[0], phases[1], phases[2], phases[3]);
+        simd::float_4 y = TestType::sin2piFixed(simdPhase);
+
+        for (int lane = 0; lane < 4; ++lane) {
+            float expected = std::sin(2.0 * M_PI * phases[lane] / 4294967296.0);
+            REQUIRE_THAT(TestType::sin2piFixed(phases[lane]), WithinAbs(expected, 1e-4));
+            REQUIRE(y[lane] == TestType::sin2piFixed(phases[lane]));
+        }
+    }
+}
+
+TEST_CASE("Sine backend distortion", "[SineBackend]") {
+    // Linear interpolation error falls 12dB per doubling of the table, cubic 24dB
+    REQUIRE(thdPlusNoise<LinearSineTable<256>>() < -80.0);
+    REQUIRE(thdPlusNoise<LinearSineTable<4096>>() < -120.0);
+    REQUIRE(thdPlusNoise<CubicSineTable<256>>() < -120.0);
+    REQUIRE(thdPlusNoise<CubicSineTable<1024>>() < -130.0);
+    REQUIRE(thdPlusNoise<MinimaxSine>() < -130.0);
+
+    REQUIRE(thdPlusNoise<LinearSineTable<4096>>() < thdPlusNoise<LinearSineTable<256>>());
+    REQUIRE(thdPlusNoise<CubicSineTable<256>>() < thdPlusNoise<LinearSineTable<256>>());
+}
+
+template <typename Sine>
+void benchmarkSineBackend(const char* name, const std::vector<float>& phases) {
+    WARN(name << ": THD+N " << thdPlusNoise<Sine>() << "dB");
+
+    BENCHMARK(std::string(name) + ", scalar") {
+        float sum = 0.f;
+        for (size_t i = 0; i < phases.size(); ++i) {
+            sum += Sine::sin2pi(phases[i]);
+        }
+        return sum;
+    };
+
+    BENCHMARK(std::string(name) + ", SIMD") {
+        simd::float_4 sum = 0.f;
+        for (size_t i = 0; i < phases.size(); i += 4) {
+            sum += Sine::sin2pi(simd::float_4::load(&phases[i]));
+        }
+        return sum[0] + sum[1] + sum[2] + sum[3];
+    };
+}
+
+TEST_CASE("Sine backend benchmark", "[.][benchmark][SineBackend]") {
+    std::vector<float> phases(4096);
+    for (size_t i = 0; i < phases.size(); ++i) {
+        phases[i] = rack::random::uniform();
+    }
+
+    benchmarkSineBackend<LinearSineTable<256>>("Linear 256", phases);
+    benchmarkSineBackend<LinearSineTable<4096>>("Linear 4096", phases);
+    benchmarkSineBackend<CubicSineTable<256>>("Cubic 256", phases);
+    benchmarkSineBackend<CubicSineTable<1024>>("Cubic 1024", phases);
+    benchmarkSineBackend<MinimaxSine>("Minimax polynomial", phases);
+}
+
+} // namespace ph
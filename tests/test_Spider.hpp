@@ -8,6 +8,7 @@
 #include <iostream>
 #include <iomanip>
 #include <limits>
+#include <cmath>
 
 using namespace rack;
 using namespace Catch;
@@ -27,10 +28,18 @@ public:
 
     int sampleRate = SAMPLES_PER_SECOND;
 
-    SpiderFixture() { spider = std::make_unique<Spider>(); }
+    SpiderFixture() {
+        spider = std::make_unique<Spider>();
+
+        // Patch the output, an unpatched module sleeps
+        spider->getOutput(Spider::AUDIO_OUTPUT).channels = 1;
+    }
 
     void doProcess(int samples, std::optional<std::function<void()>> postProcessFunction = std::nullopt,
                    std::optional<std::function<void()>> preProcessFunction = std::nullopt) {
+        // Tests edit carriers and the graph directly, so publish them the way an edit from the UI would
+        spider->updateSchedule();
+
         int frame = 0;
 
         Module::ProcessArgs processArgs;
@@ -120,7 +129,7 @@ TEST_CASE_METHOD(SpiderFixture, "Audio output is brickwalled sum of carriers") {
     spider->getParam(Spider::LEVEL_PARAMS + 1).setValue(1.f);
     spider->getParam(Spider::LEVEL_PARAMS + 2).setValue(1.f);
 
-    std::array<SpiderSignalGenerator, 3> gens;
+    std::array<FixedPhaseSignalGenerator, 3> gens;
 
     doProcess(256, [&] {
         float expected = 0.f;
@@ -152,7 +161,7 @@ TEST_CASE_METHOD(SpiderFixture, "Frequency parameter varies operator frequency c
     float expectedFreq = dsp::FREQ_C4 * dsp::exp2_taylor5(freqParam / 12.f);
 
     doProcess(256, [&] {
-        float freq = spider->freqs[op];
+        float freq = spider->engine.freqs[op * MAX_CHANNEL_COUNT];
         REQUIRE_THAT(freq, WithinAbs(expectedFreq, 0.000001));
     });
 }
@@ -169,7 +178,7 @@ TEST_CASE_METHOD(SpiderFixture, "Monophonic 1/VOct input varies operator frequen
     float expectedFreq = dsp::FREQ_C4 * dsp::exp2_taylor5(pitchInput);
 
     doProcess(256, [&] {
-        float freq = spider->freqs[op];
+        float freq = spider->engine.freqs[op * MAX_CHANNEL_COUNT];
         REQUIRE_THAT(freq, WithinAbs(expectedFreq, 0.000001));
     });
 }
@@ -181,7 +190,7 @@ TEST_CASE_METHOD(SpiderFixture, "Polyphonic 1V/Oct input sets channels") {
     spider->getInput(Spider::VOCT_INPUT).channels = channels;
 
     doProcess(1, [&] {
-        REQUIRE(spider->channels == channels);
+        REQUIRE(spider->engine.channels == channels);
     });
 }
 
@@ -205,7 +214,7 @@ TEST_CASE_METHOD(SpiderFixture, "Polyphonic 1V/Oct input varies operator frequen
 
     doProcess(256, [&] {
         for (int i = 0; i < channels; ++i) {
-            float freq = spider->freqs[op * channels + i];
+            float freq = spider->engine.freqs[op * MAX_CHANNEL_COUNT + i];
             REQUIRE_THAT(freq, WithinAbs(expectedFreqs[i], 0.000001));
         }
     });
@@ -233,12 +242,14 @@ TEST_CASE_METHOD(SpiderFixture, "Pitch shift varies operator frequency correctly
         expectedFreq *= dsp::exp2_taylor5(pitchShiftCv * normalisedPitchShiftInput);
 
         doProcess(256, [&] {
-            float freq = spider->freqs[op];
+            float freq = spider->engine.freqs[op * MAX_CHANNEL_COUNT];
             REQUIRE_THAT(freq, WithinAbs(expectedFreq, 0.000001));
         });
     }
 
     SECTION("Time-varying input CV") {
+        spider->engine.audioRateCv = true;
+
         float pitchShiftParam = 0.f;
         float pitchShiftCv = 1.f;
         float pitchShiftInput = 0.f;
@@ -261,7 +272,7 @@ TEST_CASE_METHOD(SpiderFixture, "Pitch shift varies operator frequency correctly
             float normalisedPitchShiftInput = pitchShiftInput / 10.f;
             expectedFreq *= dsp::exp2_taylor5(pitchShiftCv * normalisedPitchShiftInput);
 
-            float freq = spider->freqs[op];
+            float freq = spider->engine.freqs[op * MAX_CHANNEL_COUNT];
             REQUIRE_THAT(freq, WithinAbs(expectedFreq, 0.000001));
         };
 
@@ -291,12 +302,14 @@ TEST_CASE_METHOD(SpiderFixture, "Level varies operator level correctly", "[Integ
         expectedLevel = clamp(expectedLevel, 0.f, 1.f);
 
         doProcess(512, [&] {
-            float signal = spider->outs[op];
+            float signal = spider->engine.outs[op * MAX_CHANNEL_COUNT];
             REQUIRE_THAT(std::abs(signal), WithinAbs(expectedLevel, 0.000001));
         });
     }
 
     SECTION("Time-varying input CV") {
+        spider->engine.audioRateCv = true;
+
         float levelParam = GENERATE(take(4, random(0.f, 1.f)));
         float levelCv = GENERATE(take(4, random(-1.f, 1.f)));
 
@@ -314,7 +327,7 @@ TEST_CASE_METHOD(SpiderFixture, "Level varies operator level correctly", "[Integ
         };
 
         auto postProcess = [&] {
-            float signal = spider->outs[op];
+            float signal = spider->engine.outs[op * MAX_CHANNEL_COUNT];
             REQUIRE_THAT(std::abs(signal), WithinAbs(expectedLevel, 0.000001));
         };
 
@@ -328,7 +341,7 @@ TEST_CASE_METHOD(SpiderFixture, "Waveform blend varies operator waveform correct
     spider->getParam(Spider::LEVEL_PARAMS + op).setValue(1.f);
     spider->carriers[op] = true;
 
-    SpiderSignalGenerator gen;
+    FixedPhaseSignalGenerator gen;
 
     SECTION("Static input CV") {
         float waveParam = GENERATE(take(4, random(0.f, 1.f)));
@@ -345,11 +358,13 @@ TEST_CASE_METHOD(SpiderFixture, "Waveform blend varies operator waveform correct
 
         doProcess(512, [&] {
             float sample = gen.generate(SAMPLE_TIME, dsp::FREQ_C4, expectedWave);
-            REQUIRE_THAT(spider->outs[op], WithinAbs(sample, 0.000001));
+            REQUIRE_THAT(spider->engine.outs[op * MAX_CHANNEL_COUNT], WithinAbs(sample, 0.000001));
         });
     }
 
     SECTION("Time-varying input CV") {
+        spider->engine.audioRateCv = true;
+
         float waveParam = 0.f;
         float waveCv = 1.f;
         float waveInput = 0.f;
@@ -370,7 +385,7 @@ TEST_CASE_METHOD(SpiderFixture, "Waveform blend varies operator waveform correct
 
         auto postProcess = [&] {
             float sample = gen.generate(SAMPLE_TIME, dsp::FREQ_C4, expectedWave);
-            REQUIRE_THAT(spider->outs[op], WithinAbs(sample, 0.000001));
+            REQUIRE_THAT(spider->engine.outs[op * MAX_CHANNEL_COUNT], WithinAbs(sample, 0.000001));
         };
 
         doProcess(512, postProcess, preProcess);
@@ -382,7 +397,7 @@ TEST_CASE_METHOD(SpiderFixture, "Random combination of parameters varies operato
 
     spider->carriers[op] = true;
 
-    SpiderSignalGenerator gen;
+    FixedPhaseSignalGenerator gen;
 
     float levelParam = GENERATE(take(2, random(0.f, 1.f)));
     float levelCv = GENERATE(take(2, random(-1.f, 1.f)));
@@ -421,17 +436,50 @@ TEST_CASE_METHOD(SpiderFixture, "Random combination of parameters varies operato
     expectedWave = clamp(expectedWave, 0.f, 1.f);
 
     doProcess(512, [&] {
-        float freq = spider->freqs[op];
-        REQUIRE_THAT(freq, WithinAbs(expectedFreq, 0.000001));
+        // A silent operator isn't evaluated so it has no frequency
+        if (expectedLevel > 0.f) {
+            float freq = spider->engine.freqs[op * MAX_CHANNEL_COUNT];
+            REQUIRE_THAT(freq, WithinAbs(expectedFreq, 0.000001));
+        }
 
-        float signal = spider->outs[op];
+        float signal = spider->engine.outs[op * MAX_CHANNEL_COUNT];
 
         float sample = expectedLevel * gen.generate(SAMPLE_TIME, expectedFreq, expectedWave);
         REQUIRE_THAT(signal, WithinAbs(sample, 0.000001));
     });
 }
 
-// TODO: Polyphony tests
+TEST_CASE_METHOD(SpiderFixture, "Polyphonic channels are rendered as independent voices", "[Integration]") {
+    int channels = GENERATE(range(2, 16));
+    int op = random(0, 5).get();
+
+    float waveParam = random(0.f, 1.f).get();
+
+    spider->getParam(Spider::LEVEL_PARAMS + op).setValue(1.f);
+    spider->getParam(Spider::WAVE_PARAMS + op).setValue(waveParam);
+    spider->carriers[op] = true;
+
+    // UNSTABLE API but setChannels() checks for whether the port is connected and we're faking it...
+    spider->getInput(Spider::VOCT_INPUT).channels = channels;
+
+    std::vector<float> expectedFreqs(channels);
+    for (int i = 0; i < channels; ++i) {
+        float pitchInput = random(-2.f, 4.f).get();
+        spider->getInput(Spider::VOCT_INPUT).setVoltage(pitchInput, i);
+
+        expectedFreqs[i] = dsp::FREQ_C4 * dsp::exp2_taylor5(pitchInput);
+    }
+
+    std::vector<FixedPhaseSignalGenerator> gens(channels);
+
+    doProcess(512, [&] {
+        for (int i = 0; i < channels; ++i) {
+            float expected = gens[i].generate(SAMPLE_TIME, expectedFreqs[i], waveParam);
+            REQUIRE_THAT(spider->engine.outs[op * MAX_CHANNEL_COUNT + i], WithinAbs(expected, 0.000001));
+            REQUIRE_THAT(spider->getOutput(Spider::AUDIO_OUTPUT).getVoltage(i), WithinAbs(5.f * expected, 0.000005));
+        }
+    });
+}
 
 TEST_CASE_METHOD(SpiderFixture, "Frequency modulation of operator signals yields correct frequencies",
                  "[Integration]") {
@@ -450,12 +498,12 @@ TEST_CASE_METHOD(SpiderFixture, "Frequency modulation of operator signals yields
     spider->getParam(Spider::LEVEL_PARAMS + op2).setValue(op2level);
 
     spider->algorithmGraph.addEdge(op2, op1);
-    spider->topologicalOrder = spider->algorithmGraph.topologicalSort();
+    spider->updateSchedule();
 
-    SpiderSignalGenerator gen;
+    FixedPhaseSignalGenerator gen;
 
     doProcess(512, [&] {
-        float op1Freq = spider->freqs[op1];
+        float op1Freq = spider->engine.freqs[op1 * MAX_CHANNEL_COUNT];
 
         float expectedOp2Signal = op2level * gen.generate(SAMPLE_TIME, dsp::FREQ_C4, 0.f);
 
@@ -481,15 +529,124 @@ TEST_CASE_METHOD(SpiderFixture, "Frequency modulation with zero depth does not a
     spider->getParam(Spider::LEVEL_PARAMS + op2).setValue(op2level);
 
     spider->algorithmGraph.addEdge(op2, op1);
-    spider->topologicalOrder = spider->algorithmGraph.topologicalSort();
+    spider->updateSchedule();
 
     doProcess(512, [&] {
-        float op1Freq = spider->freqs[op1];
+        float op1Freq = spider->engine.freqs[op1 * MAX_CHANNEL_COUNT];
         float expectedFreq = dsp::FREQ_C4;
         REQUIRE_THAT(op1Freq, WithinAbs(expectedFreq, 0.0001));
     });
 }
 
+TEST_CASE_METHOD(SpiderFixture, "Operators modulating each other hear the other one sample late", "[Integration]") {
+    // 0 comes before 1 in the order, so 0 reads the previous sample of 1 and 1 reads the current sample of 0
+    spider->carriers[0] = true;
+    spider->getParam(Spider::LEVEL_PARAMS + 0).setValue(0.7f);
+    spider->getParam(Spider::LEVEL_PARAMS + 1).setValue(0.4f);
+    REQUIRE(spider->algorithmGraph.addEdge(0, 1));
+    REQUIRE(spider->algorithmGraph.addEdge(1, 0));
+
+    FixedPhaseSignalGenerator gen0;
+    FixedPhaseSignalGenerator gen1;
+    float freq0 = 0.f;
+    float out0 = 0.f;
+    float freq1 = 0.f;
+    float out1 = 0.f;
+
+    doProcess(512, [&] {
+        // 1 is fed back to 0, which scales its modulation by 1's unmodulated frequency
+        freq0 = dsp::FREQ_C4 + 5.f * dsp::FREQ_C4 * out1;
+        out0 = 0.7f * gen0.generate(SAMPLE_TIME, freq0, 0.f);
+        freq1 = dsp::FREQ_C4 + 5.f * freq0 * out0;
+        out1 = 0.4f * gen1.generate(SAMPLE_TIME, freq1, 0.f);
+
+        REQUIRE(std::isfinite(spider->engine.freqs[0 * MAX_CHANNEL_COUNT]));
+        REQUIRE(std::isfinite(spider->engine.freqs[1 * MAX_CHANNEL_COUNT]));
+        REQUIRE_THAT(spider->engine.freqs[0 * MAX_CHANNEL_COUNT], WithinRel(freq0, 0.0001f));
+        REQUIRE_THAT(spider->engine.freqs[1 * MAX_CHANNEL_COUNT], WithinRel(freq1, 0.0001f));
+    });
+}
+
+TEST_CASE_METHOD(SpiderFixture, "Operators modulating each other at full level keep oscillating", "[Integration]") {
+    spider->carriers[0] = true;
+    spider->getParam(Spider::LEVEL_PARAMS + 0).setValue(1.f);
+    spider->getParam(Spider::LEVEL_PARAMS + 1).setValue(1.f);
+    spider->engine.bandLimited = GENERATE(false, true);
+    REQUIRE(spider->algorithmGraph.addEdge(0, 1));
+    REQUIRE(spider->algorithmGraph.addEdge(1, 0));
+    spider->setModulationDepth(0, 1, 2.f);
+    spider->setModulationDepth(1, 0, 2.f);
+
+    // A loop that fed its modulation back into itself would drive both frequencies to infinity and leave the output
+    // stuck at a constant
+    int frames = 3 * sampleRate;
+    float low = INFINITY;
+    float high = -INFINITY;
+    int frame = 0;
+    doProcess(frames, [&] {
+        REQUIRE(std::isfinite(spider->engine.freqs[0 * MAX_CHANNEL_COUNT]));
+        REQUIRE(std::isfinite(spider->engine.freqs[1 * MAX_CHANNEL_COUNT]));
+
+        if (++frame > frames - sampleRate) {
+            float voltage = spider->getOutput(Spider::AUDIO_OUTPUT).getVoltage();
+            low = std::min(low, voltage);
+            high = std::max(high, voltage);
+        }
+    });
+
+    REQUIRE(high - low > 5.f);
+}
+
+TEST_CASE_METHOD(SpiderFixture, "Modulation depth scales the modulation index", "[Integration]") {
+    int op1 = GENERATE(0, 1, 2, 3, 4, 5);
+    int op2 = GENERATE(0, 1, 2, 3, 4, 5);
+
+    if (op1 == op2)
+        return;
+
+    spider->carriers[op1] = true;
+    spider->getParam(Spider::LEVEL_PARAMS + op1).setValue(1.f);
+    spider->algorithmGraph.addEdge(op2, op1);
+
+    SECTION("Zero depth removes the modulation") {
+        spider->getParam(Spider::LEVEL_PARAMS + op2).setValue(1.f);
+        spider->setModulationDepth(op2, op1, 0.f);
+
+        doProcess(512, [&] { REQUIRE(spider->engine.freqs[op1 * MAX_CHANNEL_COUNT] == dsp::FREQ_C4); });
+    }
+
+    SECTION("Halving the depth is the same as halving the modulator level") {
+        // The reference module modulates at full depth from a modulator at half level
+        auto reference = std::make_unique<Spider>();
+        reference->getOutput(Spider::AUDIO_OUTPUT).channels = 1;
+        reference->carriers[op1] = true;
+        reference->getParam(Spider::LEVEL_PARAMS + op1).setValue(1.f);
+        reference->getParam(Spider::LEVEL_PARAMS + op2).setValue(0.5f);
+        reference->algorithmGraph.addEdge(op2, op1);
+        reference->updateSchedule();
+
+        spider->getParam(Spider::LEVEL_PARAMS + op2).setValue(1.f);
+        spider->setModulationDepth(op2, op1, 0.5f);
+
+        Module::ProcessArgs processArgs;
+        processArgs.sampleRate = sampleRate;
+        processArgs.sampleTime = 1.f / sampleRate;
+
+        doProcess(512, [&] {
+            reference->process(processArgs);
+            REQUIRE(spider->getOutput(Spider::AUDIO_OUTPUT).getVoltage() ==
+                    reference->getOutput(Spider::AUDIO_OUTPUT).getVoltage());
+        });
+    }
+
+    SECTION("Depth is clamped") {
+        spider->setModulationDepth(op2, op1, 5.f);
+        REQUIRE(spider->modulationDepths[op2][op1] == 2.f);
+        spider->setModulationDepth(op2, op1, -1.f);
+        REQUIRE(spider->modulationDepths[op2][op1] == 0.f);
+    }
+}
+
 TEST_CASE_METHOD(SpiderFixture, "Frequency modulation in polyphonic mode yields correct frequencies", "[Integration]") {
     int op1 = GENERATE(0, 1, 2, 3, 4, 5);
     int op2 = GENERATE(0, 1, 2, 3, 4, 5);
@@ -519,13 +676,13 @@ TEST_CASE_METHOD(SpiderFixture, "Frequency modulation in polyphonic mode yields
     spider->getParam(Spider::LEVEL_PARAMS + op2).setValue(op2level);
 
     spider->algorithmGraph.addEdge(op2, op1);
-    spider->topologicalOrder = spider->algorithmGraph.topologicalSort();
+    spider->updateSchedule();
 
-    std::vector<SpiderSignalGenerator> gens(channels);
+    std::vector<FixedPhaseSignalGenerator> gens(channels);
 
     doProcess(512, [&] {
         for (int i = 0; i < channels; ++i) {
-            float op1Freq = spider->freqs[op1 * channels + i];
+            float op1Freq = spider->engine.freqs[op1 * MAX_CHANNEL_COUNT + i];
 
             float expectedOp2Signal = op2level * gens[i].generate(SAMPLE_TIME, expectedFreqs[i], 0.f);
 
@@ -558,12 +715,12 @@ TEST_CASE_METHOD(SpiderFixture, "Frequency modulation with non-sine signals yiel
     spider->getParam(Spider::WAVE_PARAMS + op2).setValue(op2Wave);
 
     spider->algorithmGraph.addEdge(op2, op1);
-    spider->topologicalOrder = spider->algorithmGraph.topologicalSort();
+    spider->updateSchedule();
 
-    SpiderSignalGenerator gen;
+    FixedPhaseSignalGenerator gen;
 
     doProcess(512, [&] {
-        float op1Freq = spider->freqs[op1];
+        float op1Freq = spider->engine.freqs[op1 * MAX_CHANNEL_COUNT];
 
         float expectedOp2Signal = op2level * gen.generate(SAMPLE_TIME, dsp::FREQ_C4, op2Wave);
 
@@ -595,12 +752,12 @@ TEST_CASE_METHOD(SpiderFixture, "Frequency modulation with different sample rate
     spider->getParam(Spider::LEVEL_PARAMS + op2).setValue(op2level);
 
     spider->algorithmGraph.addEdge(op2, op1);
-    spider->topologicalOrder = spider->algorithmGraph.topologicalSort();
+    spider->updateSchedule();
 
-    SpiderSignalGenerator gen;
+    FixedPhaseSignalGenerator gen;
 
     doProcess(512, [&] {
-        float op1Freq = spider->freqs[op1];
+        float op1Freq = spider->engine.freqs[op1 * MAX_CHANNEL_COUNT];
 
         float expectedOp2Signal = op2level * gen.generate(1.f / sampleRate, dsp::FREQ_C4, 0.f);
 
@@ -630,14 +787,14 @@ TEST_CASE_METHOD(SpiderFixture, "Frequency modulation of modulator signals yield
 
     spider->algorithmGraph.addEdge(op2, op1);
     spider->algorithmGraph.addEdge(op3, op2);
-    spider->topologicalOrder = spider->algorithmGraph.topologicalSort();
+    spider->updateSchedule();
 
-    SpiderSignalGenerator genOp2;
-    SpiderSignalGenerator genOp3;
+    FixedPhaseSignalGenerator genOp2;
+    FixedPhaseSignalGenerator genOp3;
 
     doProcess(512, [&] {
-        float op1Freq = spider->freqs[op1];
-        float op2Freq = spider->freqs[op2];
+        float op1Freq = spider->engine.freqs[op1 * MAX_CHANNEL_COUNT];
+        float op2Freq = spider->engine.freqs[op2 * MAX_CHANNEL_COUNT];
 
         float expectedOp3Signal = op3level * genOp3.generate(SAMPLE_TIME, dsp::FREQ_C4, 0.f);
         float expectedOp2Freq = dsp::FREQ_C4 + 5.f * dsp::FREQ_C4 * expectedOp3Signal;
@@ -672,12 +829,12 @@ TEST_CASE_METHOD(SpiderFixture, "Frequency modulation from multiple modulators o
 
     spider->algorithmGraph.addEdge(op2, op1);
     spider->algorithmGraph.addEdge(op3, op1);
-    spider->topologicalOrder = spider->algorithmGraph.topologicalSort();
+    spider->updateSchedule();
 
-    SpiderSignalGenerator gen;
+    FixedPhaseSignalGenerator gen;
 
     doProcess(512, [&] {
-        float op1Freq = spider->freqs[op1];
+        float op1Freq = spider->engine.freqs[op1 * MAX_CHANNEL_COUNT];
 
         float expectedModSignal = op2level * gen.generate(SAMPLE_TIME, dsp::FREQ_C4, 0.f);
 
@@ -689,12 +846,660 @@ TEST_CASE_METHOD(SpiderFixture, "Frequency modulation from multiple modulators o
     });
 }
 
+TEST_CASE_METHOD(SpiderFixture, "Rendering a block matches rendering frame by frame", "[Integration]") {
+    int channels = GENERATE(1, 4, 7, 16);
+    int frames = GENERATE(1, 16, 64);
+
+    auto blockSpider = std::make_unique<Spider>();
+
+    for (Spider* s : {spider.get(), blockSpider.get()}) {
+        for (int op = 0; op < 6; ++op) {
+            s->getParam(Spider::LEVEL_PARAMS + op).setValue(0.2f + 0.1f * op);
+            s->getParam(Spider::WAVE_PARAMS + op).setValue(0.15f * op);
+            s->getParam(Spider::PITCH_PARAMS + op).setValue(op - 3.f);
+            s->getParam(Spider::FEEDBACK_PARAMS + op).setValue(0.05f * op);
+        }
+
+        s->carriers[0] = true;
+        s->carriers[3] = true;
+        s->algorithmGraph.addEdge(1, 0);
+        s->algorithmGraph.addEdge(2, 1);
+        s->algorithmGraph.addEdge(4, 3);
+        s->algorithmGraph.addEdge(5, 3);
+        s->updateSchedule();
+        s->receiveSchedule();
+
+        s->getInput(Spider::VOCT_INPUT).channels = channels;
+        s->engine.channels = channels;
+    }
+
+    std::vector<float> pitch(frames * MAX_CHANNEL_COUNT);
+    for (int frame = 0; frame < frames; ++frame) {
+        for (int c = 0; c < MAX_CHANNEL_COUNT; ++c) {
+            pitch[frame * MAX_CHANNEL_COUNT + c] = std::sin(0.1f * frame + c);
+        }
+    }
+
+    Module::ProcessArgs processArgs;
+    processArgs.sampleRate = sampleRate;
+    processArgs.sampleTime = 1.f / sampleRate;
+
+    std::vector<float> output(frames * MAX_CHANNEL_COUNT);
+    blockSpider->renderBlock(processArgs, frames, pitch.data(), output.data());
+
+    for (int frame = 0; frame < frames; ++frame) {
+        for (int c = 0; c < channels; ++c) {
+            spider->getInput(Spider::VOCT_INPUT).setVoltage(pitch[frame * MAX_CHANNEL_COUNT + c], c);
+        }
+
+        spider->process(processArgs);
+
+        for (int c = 0; c < channels; ++c) {
+            float expected = spider->getOutput(Spider::AUDIO_OUTPUT).getVoltage(c);
+            REQUIRE_THAT(5.f * output[frame * MAX_CHANNEL_COUNT + c], WithinAbs(expected, 0.000001));
+        }
+    }
+}
+
+TEST_CASE_METHOD(SpiderFixture, "Control-rate params are ramped between control samples", "[Integration]") {
+    int op = GENERATE(0, 3, 5);
+    int division = GENERATE(4, 16, 64);
+
+    spider->engine.controlDivision = division;
+    spider->carriers[op] = true;
+
+    // square wave so the output magnitude is the level
+    spider->getParam(Spider::WAVE_PARAMS + op).setValue(0.75f);
+    spider->getParam(Spider::LEVEL_PARAMS + op).setValue(0.f);
+
+    doProcess(division, [&] { REQUIRE(spider->engine.outs[op * MAX_CHANNEL_COUNT] == 0.f); });
+
+    spider->getParam(Spider::LEVEL_PARAMS + op).setValue(1.f);
+
+    int frame = 0;
+    doProcess(division, [&] {
+        frame++;
+        float expectedLevel = float(frame) / division;
+        REQUIRE_THAT(std::abs(spider->engine.outs[op * MAX_CHANNEL_COUNT]), WithinAbs(expectedLevel, 0.0001));
+    });
+
+    doProcess(division, [&] { REQUIRE(std::abs(spider->engine.outs[op * MAX_CHANNEL_COUNT]) == 1.f); });
+}
+
+TEST_CASE_METHOD(SpiderFixture, "Control-rate CV is held until the next control sample", "[Integration]") {
+    int op = GENERATE(0, 3, 5);
+
+    spider->carriers[op] = true;
+    spider->getParam(Spider::WAVE_PARAMS + op).setValue(0.75f);
+    spider->getParam(Spider::LEVEL_CV_PARAMS + op).setValue(1.f);
+    spider->getInput(Spider::LEVEL_INPUTS + op).setVoltage(5.f);
+
+    doProcess(1);
+    REQUIRE_THAT(std::abs(spider->engine.outs[op * MAX_CHANNEL_COUNT]), WithinAbs(0.5f, 0.000001));
+
+    // A change between control samples is not seen until the next one
+    spider->getInput(Spider::LEVEL_INPUTS + op).setVoltage(10.f);
+    doProcess(spider->engine.controlDivision - 1,
+              [&] { REQUIRE_THAT(std::abs(spider->engine.outs[op * MAX_CHANNEL_COUNT]), WithinAbs(0.5f, 0.000001)); });
+
+    doProcess(1);
+    REQUIRE(std::abs(spider->engine.outs[op * MAX_CHANNEL_COUNT]) > 0.5f);
+}
+
+TEST_CASE_METHOD(SpiderFixture, "Edits only reach the audio thread once published", "[Integration]") {
+    spider->getParam(Spider::LEVEL_PARAMS + 0).setValue(1.f);
+    spider->getParam(Spider::WAVE_PARAMS + 0).setValue(0.75f);
+
+    Module::ProcessArgs processArgs;
+    processArgs.sampleRate = sampleRate;
+    processArgs.sampleTime = 1.f / sampleRate;
+
+    spider->carriers[0] = true;
+    spider->process(processArgs);
+    REQUIRE(spider->getOutput(Spider::AUDIO_OUTPUT).getVoltage() == 0.f);
+
+    // The first carrier wakes the module, which fades in
+    spider->publishSchedule();
+    spider->process(processArgs);
+    REQUIRE(spider->getOutput(Spider::AUDIO_OUTPUT).getVoltage() != 0.f);
+
+    doProcess(sampleRate * WAKE_FADE_TIME);
+    REQUIRE(std::abs(spider->getOutput(Spider::AUDIO_OUTPUT).getVoltage()) == 5.f);
+}
+
+TEST_CASE_METHOD(SpiderFixture, "Edits published while the queue is full are sent later", "[Integration]") {
+    spider->getParam(Spider::LEVEL_PARAMS + 0).setValue(1.f);
+    spider->getParam(Spider::WAVE_PARAMS + 0).setValue(0.75f);
+
+    // Nothing is processing so the queue fills up
+    for (int i = 0; i < 16; ++i) {
+        spider->publishSchedule();
+    }
+    REQUIRE(spider->schedulePending);
+
+    spider->carriers[0] = true;
+    spider->publishSchedule();
+
+    Module::ProcessArgs processArgs;
+    processArgs.sampleRate = sampleRate;
+    processArgs.sampleTime = 1.f / sampleRate;
+
+    spider->process(processArgs);
+    REQUIRE(spider->getOutput(Spider::AUDIO_OUTPUT).getVoltage() == 0.f);
+
+    spider->processEdit(1.f / 60.f);
+    REQUIRE_FALSE(spider->schedulePending);
+
+    spider->process(processArgs);
+    REQUIRE(spider->getOutput(Spider::AUDIO_OUTPUT).getVoltage() != 0.f);
+
+    doProcess(sampleRate * WAKE_FADE_TIME);
+    REQUIRE(std::abs(spider->getOutput(Spider::AUDIO_OUTPUT).getVoltage()) == 5.f);
+}
+
+TEST_CASE_METHOD(SpiderFixture, "Scopes only capture while a display is drawing", "[Integration]") {
+    int op = GENERATE(0, 2, 5);
+
+    // Square wave so every captured point is +-1
+    spider->carriers[op] = true;
+    spider->getParam(Spider::LEVEL_PARAMS + op).setValue(1.f);
+    spider->getParam(Spider::WAVE_PARAMS + op).setValue(0.75f);
+
+    doProcess(SAMPLES_PER_SECOND / 2);
+    REQUIRE_FALSE(spider->engine.scopes[op].update());
+
+    spider->engine.scopesRequested = true;
+    doProcess(SAMPLES_PER_SECOND / 4);
+    REQUIRE(spider->engine.scopes[op].update());
+
+    // One point per period of C4
+    int points = 0;
+    for (size_t i = 0; i < SCOPE_SIZE; ++i) {
+        if (spider->engine.scopes[op].point(i) != 0.f) {
+            REQUIRE(std::abs(spider->engine.scopes[op].point(i)) == 1.f);
+            points++;
+        }
+    }
+    REQUIRE_THAT(float(points), WithinAbs(dsp::FREQ_C4 / 4, 2));
+
+    // Without another request capture stops after the next check
+    doProcess(SAMPLES_PER_SECOND / 2);
+    spider->engine.scopes[op].update();
+    doProcess(SAMPLES_PER_SECOND / 4);
+    REQUIRE_FALSE(spider->engine.scopes[op].update());
+}
+
+TEST_CASE_METHOD(SpiderFixture, "Operators that can't reach the output are not evaluated", "[Integration]") {
+    for (int op = 0; op < 3; ++op) {
+        spider->getParam(Spider::LEVEL_PARAMS + op).setValue(1.f);
+    }
+    spider->carriers[0] = true;
+    spider->algorithmGraph.addEdge(1, 0);
+
+    doProcess(64);
+
+    // Operator 2 modulates nothing, its generator never runs and it outputs nothing
+    REQUIRE(spider->engine.outs[2 * MAX_CHANNEL_COUNT] == 0.f);
+    REQUIRE(spider->engine.signalGenerators[2 * SIMD_GROUP_COUNT].phase[0] == 0);
+    REQUIRE(spider->engine.outs[1 * MAX_CHANNEL_COUNT] != 0.f);
+
+    // Silencing the carrier kills its modulator too, and both outputs go back to zero
+    spider->getParam(Spider::LEVEL_PARAMS + 0).setValue(0.f);
+    doProcess(64);
+
+    REQUIRE(spider->engine.outs[0] == 0.f);
+    REQUIRE(spider->engine.outs[1 * MAX_CHANNEL_COUNT] == 0.f);
+    REQUIRE(spider->getOutput(Spider::AUDIO_OUTPUT).getVoltage() == 0.f);
+
+    // Connecting operator 2 brings it back to life
+    spider->getParam(Spider::LEVEL_PARAMS + 0).setValue(1.f);
+    spider->algorithmGraph.addEdge(2, 0);
+    doProcess(64);
+
+    REQUIRE(spider->engine.outs[2 * MAX_CHANNEL_COUNT] != 0.f);
+}
+
+TEST_CASE_METHOD(SpiderFixture, "Unconnected operators still show on their scopes", "[Integration]") {
+    spider->getInput(Spider::VOCT_INPUT).channels = 8;
+    spider->carriers[0] = true;
+    spider->getParam(Spider::LEVEL_PARAMS + 3).setValue(1.f);
+    spider->engine.scopesRequested = true;
+
+    doProcess(64);
+
+    // Only the first group of channels, the one the scopes show, is evaluated
+    REQUIRE(spider->engine.outs[3 * MAX_CHANNEL_COUNT] != 0.f);
+    REQUIRE(spider->engine.outs[3 * MAX_CHANNEL_COUNT + 4] == 0.f);
+}
+
+TEST_CASE_METHOD(SpiderFixture, "Dead operator benchmark", "[.][benchmark]") {
+    const int frames = 256;
+    const int channels = GENERATE(1, 16);
+
+    for (int op = 0; op < 6; ++op) {
+        spider->getParam(Spider::LEVEL_PARAMS + op).setValue(0.8f);
+    }
+    spider->carriers[0] = true;
+    spider->algorithmGraph.addEdge(1, 0);
+    spider->engine.channels = channels;
+
+    std::vector<float> pitch(frames * MAX_CHANNEL_COUNT, 0.f);
+    std::vector<float> output(frames * MAX_CHANNEL_COUNT);
+
+    Module::ProcessArgs processArgs;
+    processArgs.sampleRate = sampleRate;
+    processArgs.sampleTime = 1.f / sampleRate;
+
+    spider->updateSchedule();
+    spider->receiveSchedule();
+    BENCHMARK(std::to_string(channels) + " channels, 2-op bass with four unconnected operators") {
+        spider->renderBlock(processArgs, frames, pitch.data(), output.data());
+        return output[0];
+    };
+
+    for (int op = 2; op < 6; ++op) {
+        spider->carriers[op] = true;
+    }
+    spider->updateSchedule();
+    spider->receiveSchedule();
+    BENCHMARK(std::to_string(channels) + " channels, all six operators live") {
+        spider->renderBlock(processArgs, frames, pitch.data(), output.data());
+        return output[0];
+    };
+}
+
+TEST_CASE_METHOD(SpiderFixture, "Mono patches render the same across operators as across channels", "[Integration]") {
+    // The second module plays the same note on two channels, which forces the channel-parallel path
+    auto polySpider = std::make_unique<Spider>();
+    polySpider->getOutput(Spider::AUDIO_OUTPUT).channels = 2;
+    polySpider->getInput(Spider::VOCT_INPUT).channels = 2;
+
+    bool bandLimited = GENERATE(false, true);
+    int oversampling = GENERATE(1, 4);
+    bool scopes = GENERATE(false, true);
+    bool cyclic = GENERATE(false, true);
+
+    // Two carriers with modulators on several levels, including one with two modulators and an unconnected operator.
+    // The cyclic patch closes a loop of three and a loop of two.
+    for (Spider* module : {spider.get(), polySpider.get()}) {
+        module->algorithmGraph.addEdge(1, 0);
+        module->algorithmGraph.addEdge(2, 0);
+        module->algorithmGraph.addEdge(3, 1);
+        module->algorithmGraph.addEdge(5, 4);
+        if (cyclic) {
+            module->algorithmGraph.addEdge(0, 3);
+            module->algorithmGraph.addEdge(4, 5);
+        }
+        module->carriers[0] = true;
+        module->carriers[4] = true;
+
+        for (int op = 0; op < 6; ++op) {
+            module->getParam(Spider::LEVEL_PARAMS + op).setValue(0.2f + 0.1f * op);
+            module->getParam(Spider::PITCH_PARAMS + op).setValue(op - 2.f);
+            module->getParam(Spider::WAVE_PARAMS + op).setValue(0.15f * op);
+            module->getParam(Spider::FEEDBACK_PARAMS + op).setValue(0.05f * op);
+        }
+        module->engine.bandLimited = bandLimited;
+        module->engine.oversampling = oversampling;
+        module->engine.scopesRequested = scopes;
+        module->updateSchedule();
+        module->setModulationDepth(2, 0, 0.4f);
+        module->setModulationDepth(5, 4, 1.7f);
+    }
+
+    Module::ProcessArgs processArgs;
+    processArgs.sampleRate = sampleRate;
+    processArgs.sampleTime = 1.f / sampleRate;
+
+    for (int frame = 0; frame < 2048; ++frame) {
+        // Move a level so the ramps are exercised too
+        if (frame == 1000) {
+            spider->getParam(Spider::LEVEL_PARAMS + 2).setValue(0.9f);
+            polySpider->getParam(Spider::LEVEL_PARAMS + 2).setValue(0.9f);
+        }
+
+        spider->process(processArgs);
+        polySpider->process(processArgs);
+
+        REQUIRE(spider->getOutput(Spider::AUDIO_OUTPUT).getVoltage(0) ==
+                polySpider->getOutput(Spider::AUDIO_OUTPUT).getVoltage(0));
+    }
+
+    REQUIRE(spider->engine.wavefronts.vectorCount < spider->engine.liveOperators.count);
+    for (int op = 0; op < 6; ++op) {
+        REQUIRE(spider->engine.outs[op * MAX_CHANNEL_COUNT] == polySpider->engine.outs[op * MAX_CHANNEL_COUNT]);
+        REQUIRE(spider->engine.signalGenerators[op * SIMD_GROUP_COUNT].phase[0] ==
+                polySpider->engine.signalGenerators[op * SIMD_GROUP_COUNT].phase[0]);
+    }
+}
+
+TEST_CASE_METHOD(SpiderFixture, "Mono wavefront benchmark", "[.][benchmark]") {
+    const int frames = 256;
+
+    for (int op = 0; op < 6; ++op) {
+        spider->getParam(Spider::LEVEL_PARAMS + op).setValue(0.8f);
+    }
+    spider->engine.channels = 1;
+
+    std::vector<float> pitch(frames * MAX_CHANNEL_COUNT, 0.f);
+    std::vector<float> output(frames * MAX_CHANNEL_COUNT);
+
+    Module::ProcessArgs processArgs;
+    processArgs.sampleRate = sampleRate;
+    processArgs.sampleTime = 1.f / sampleRate;
+
+    // Two channels cost the same as one on the channel-parallel path, so they show what mono used to cost
+    auto run = [&](const std::string& name) {
+        spider->updateSchedule();
+        spider->receiveSchedule();
+        spider->renderBlock(processArgs, frames, pitch.data(), output.data());
+        WARN(name << ": " << spider->engine.wavefronts.vectorCount << " vectors for "
+                  << spider->engine.liveOperators.count << " operators");
+
+        spider->engine.channels = 1;
+        BENCHMARK(name + ", 1 channel") {
+            spider->renderBlock(processArgs, frames, pitch.data(), output.data());
+            return output[0];
+        };
+
+        spider->engine.channels = 2;
+        BENCHMARK(name + ", 2 channels") {
+            spider->renderBlock(processArgs, frames, pitch.data(), output.data());
+            return output[0];
+        };
+        spider->engine.channels = 1;
+    };
+
+    // Six carriers, one wavefront of two vectors
+    for (int op = 0; op < 6; ++op) {
+        spider->carriers[op] = true;
+    }
+    run("Six parallel carriers");
+
+    // Three 2-op stacks, two wavefronts
+    for (int op = 0; op < 6; op += 2) {
+        spider->carriers[op + 1] = false;
+        spider->algorithmGraph.addEdge(op + 1, op);
+    }
+    run("Three 2-op stacks");
+
+    // A chain of six has one operator per wavefront, so it runs across channels as before
+    for (int op = 2; op < 6; op += 2) {
+        spider->carriers[op] = false;
+        spider->algorithmGraph.addEdge(op, op - 1);
+    }
+    run("Chain of six");
+}
+
+TEST_CASE_METHOD(SpiderFixture, "Editing a library algorithm by hand leaves the library", "[Integration]") {
+    spider->loadAlgorithm(4);
+    REQUIRE(spider->libraryAlgorithm == 4);
+    REQUIRE(spider->carriers == std::array<bool, 6>{true, false, true, false, true, false});
+    REQUIRE(spider->algorithmGraph.hasEdge(1, 0));
+
+    // Triggers start high, so the buttons have to be seen released first
+    spider->processEdit(0.01f);
+
+    // Select operator 6, then operator 1 to connect them
+    auto press = [&](int op) {
+        spider->getParam(Spider::SELECT_PARAMS + op).setValue(1.f);
+        spider->processEdit(0.01f);
+        spider->getParam(Spider::SELECT_PARAMS + op).setValue(0.f);
+        spider->processEdit(0.01f);
+    };
+    press(5);
+    press(0);
+
+    REQUIRE(spider->algorithmGraph.hasEdge(5, 0));
+    REQUIRE(spider->libraryAlgorithm == -1);
+    REQUIRE(spider->pendingSchedule.libraryAlgorithm == -1);
+}
+
+TEST_CASE_METHOD(SpiderFixture, "Library algorithms render the same on their kernels", "[Integration]") {
+    // The second module loads the same routing by hand, so it renders on the generic engine
+    auto genericSpider = std::make_unique<Spider>();
+
+    int index = GENERATE(range(0, LIBRARY_ALGORITHM_COUNT));
+    bool bandLimited = GENERATE(false, true);
+    int oversampling = GENERATE(1, 4);
+
+    spider->loadAlgorithm(index);
+    loadLibraryAlgorithm(index, genericSpider->algorithmGraph, genericSpider->carriers);
+    genericSpider->updateSchedule();
+
+    for (Spider* module : {spider.get(), genericSpider.get()}) {
+        module->getOutput(Spider::AUDIO_OUTPUT).channels = 5;
+        module->getInput(Spider::VOCT_INPUT).channels = 5;
+        for (int c = 0; c < 5; ++c) {
+            module->getInput(Spider::VOCT_INPUT).setVoltage(c / 12.f, c);
+        }
+
+        // Operator 4 is silent, so the operators that only reach the output through it aren't evaluated
+        for (int op = 0; op < 6; ++op) {
+            module->getParam(Spider::LEVEL_PARAMS + op).setValue(op == 3 ? 0.f : 0.2f + 0.1f * op);
+            module->getParam(Spider::PITCH_PARAMS + op).setValue(op - 2.f);
+            module->getParam(Spider::WAVE_PARAMS + op).setValue(0.15f * op);
+            module->getParam(Spider::FEEDBACK_PARAMS + op).setValue(0.05f * op);
+        }
+        module->engine.bandLimited = bandLimited;
+        module->engine.oversampling = oversampling;
+        for (int mod = 1; mod < 6; ++mod) {
+            module->setModulationDepth(mod, mod - 1, 0.3f * mod);
+        }
+    }
+
+    Module::ProcessArgs processArgs;
+    processArgs.sampleRate = sampleRate;
+    processArgs.sampleTime = 1.f / sampleRate;
+
+    for (int frame = 0; frame < 1024; ++frame) {
+        spider->process(processArgs);
+        genericSpider->process(processArgs);
+
+        for (int c = 0; c < 5; ++c) {
+            REQUIRE(spider->getOutput(Spider::AUDIO_OUTPUT).getVoltage(c) ==
+                    genericSpider->getOutput(Spider::AUDIO_OUTPUT).getVoltage(c));
+        }
+    }
+
+    REQUIRE(spider->engine.schedule.libraryAlgorithm == index);
+    REQUIRE(genericSpider->engine.schedule.libraryAlgorithm == -1);
+}
+
+TEST_CASE_METHOD(SpiderFixture, "Connecting an operator back to its modulator makes a loop", "[Integration]") {
+    spider->processEdit(0.01f);
+
+    auto press = [&](int op) {
+        spider->getParam(Spider::SELECT_PARAMS + op).setValue(1.f);
+        spider->processEdit(0.01f);
+        spider->getParam(Spider::SELECT_PARAMS + op).setValue(0.f);
+        spider->processEdit(0.01f);
+    };
+    press(2);
+    press(1);
+    press(1);
+    press(2);
+
+    REQUIRE(spider->algorithmGraph.hasEdge(2, 1));
+    REQUIRE(spider->algorithmGraph.hasEdge(1, 2));
+    REQUIRE(spider->getLight(Spider::CONNECTION_LIGHTS + 2 * 6 + 1).getBrightness() == 1.f);
+    REQUIRE(spider->getLight(Spider::CONNECTION_LIGHTS + 1 * 6 + 2).getBrightness() == 1.f);
+    REQUIRE(spider->pendingSchedule.cyclic);
+}
+
+TEST_CASE_METHOD(SpiderFixture, "Returning to a recent routing reuses its schedule", "[Integration]") {
+    spider->loadAlgorithm(0);
+    RoutingSchedule<OPERATOR_COUNT> first = spider->pendingSchedule;
+    std::array<int, OPERATOR_COUNT> firstOrder = spider->topologicalOrder;
+
+    spider->loadAlgorithm(15);
+    REQUIRE(spider->pendingSchedule.carrierCount == 1);
+
+    int misses = spider->scheduleCache.misses;
+    int hits = spider->scheduleCache.hits;
+    spider->loadAlgorithm(0);
+
+    REQUIRE(spider->scheduleCache.misses == misses);
+    REQUIRE(spider->scheduleCache.hits == hits + 1);
+    REQUIRE(spider->topologicalOrder == firstOrder);
+    REQUIRE(spider->pendingSchedule.order == first.order);
+    REQUIRE(spider->pendingSchedule.modulators == first.modulators);
+    REQUIRE(spider->pendingSchedule.carriers == first.carriers);
+    REQUIRE(spider->pendingSchedule.levels == first.levels);
+
+    // The same graph with different carriers is a different routing
+    spider->carriers[1] = true;
+    spider->publishSchedule();
+    REQUIRE(spider->scheduleCache.misses == misses + 1);
+    REQUIRE(spider->pendingSchedule.carrierCount == 3);
+}
+
+TEST_CASE_METHOD(SpiderFixture, "Module sleeps while nothing can be heard", "[Integration]") {
+    spider->getParam(Spider::LEVEL_PARAMS + 0).setValue(1.f);
+    spider->getParam(Spider::WAVE_PARAMS + 0).setValue(0.75f);
+
+    SECTION("Output unpatched") {
+        spider->carriers[0] = true;
+        spider->getOutput(Spider::AUDIO_OUTPUT).channels = 0;
+    }
+
+    SECTION("No carriers") {}
+
+    doProcess(64);
+
+    REQUIRE(spider->engine.idle);
+    REQUIRE(spider->engine.signalGenerators[0].phase[0] == 0);
+    REQUIRE(spider->engine.outs[0] == 0.f);
+    REQUIRE(spider->getOutput(Spider::AUDIO_OUTPUT).getVoltage() == 0.f);
+}
+
+TEST_CASE_METHOD(SpiderFixture, "Module fades in when it wakes", "[Integration]") {
+    spider->carriers[0] = true;
+    spider->getParam(Spider::LEVEL_PARAMS + 0).setValue(1.f);
+    spider->getParam(Spider::WAVE_PARAMS + 0).setValue(0.75f);
+    doProcess(64);
+
+    // Unpatch and patch the output again
+    spider->getOutput(Spider::AUDIO_OUTPUT).channels = 0;
+    doProcess(64);
+    REQUIRE(spider->engine.idle);
+    spider->getOutput(Spider::AUDIO_OUTPUT).channels = 1;
+
+    int fadeFrames = sampleRate * WAKE_FADE_TIME;
+    float lastVoltage = 0.f;
+    doProcess(fadeFrames, [&] {
+        // A square wave only changes sign, so the fade is the only change in magnitude
+        float voltage = std::abs(spider->getOutput(Spider::AUDIO_OUTPUT).getVoltage());
+        REQUIRE(voltage > lastVoltage);
+        REQUIRE(voltage - lastVoltage <= 5.f / fadeFrames + 0.00001f);
+        lastVoltage = voltage;
+    });
+
+    REQUIRE_FALSE(spider->engine.idle);
+    REQUIRE(lastVoltage == 5.f);
+}
+
+TEST_CASE_METHOD(SpiderFixture, "Idle benchmark", "[.][benchmark]") {
+    spider->getInput(Spider::VOCT_INPUT).channels = 16;
+    for (int op = 0; op < 6; ++op) {
+        spider->carriers[op] = true;
+        spider->getParam(Spider::LEVEL_PARAMS + op).setValue(0.8f);
+    }
+    spider->updateSchedule();
+
+    Module::ProcessArgs processArgs;
+    processArgs.sampleRate = sampleRate;
+    processArgs.sampleTime = 1.f / sampleRate;
+
+    BENCHMARK("16 channels, six carriers, 256 frames") {
+        for (int i = 0; i < 256; ++i) {
+            spider->process(processArgs);
+        }
+        return spider->getOutput(Spider::AUDIO_OUTPUT).getVoltage();
+    };
+
+    spider->getOutput(Spider::AUDIO_OUTPUT).channels = 0;
+    BENCHMARK("16 channels, six carriers, output unpatched, 256 frames") {
+        for (int i = 0; i < 256; ++i) {
+            spider->process(processArgs);
+        }
+        return spider->getOutput(Spider::AUDIO_OUTPUT).getVoltage();
+    };
+}
+
+TEST_CASE_METHOD(SpiderFixture, "Oversampling keeps the level and pitch of a sine carrier", "[Integration]") {
+    int factor = GENERATE(2, 4, 8);
+
+    spider->engine.oversampling = factor;
+    spider->carriers[0] = true;
+    spider->getParam(Spider::LEVEL_PARAMS + 0).setValue(1.f);
+
+    // Count rising zero crossings and the RMS over one second after the decimators settle
+    doProcess(256);
+
+    float lastVoltage = spider->getOutput(Spider::AUDIO_OUTPUT).getVoltage();
+    int crossings = 0;
+    double sumOfSquares = 0.0;
+
+    doProcess(SAMPLES_PER_SECOND, [&] {
+        float voltage = spider->getOutput(Spider::AUDIO_OUTPUT).getVoltage();
+        if (lastVoltage < 0.f && voltage >= 0.f) {
+            crossings++;
+        }
+        lastVoltage = voltage;
+        sumOfSquares += voltage * voltage;
+    });
+
+    float rms = std::sqrt(sumOfSquares / SAMPLES_PER_SECOND);
+    REQUIRE_THAT(rms, WithinAbs(5.f / std::sqrt(2.f), 0.05));
+    REQUIRE_THAT(float(crossings), WithinAbs(dsp::FREQ_C4, 1.0));
+}
+
+TEST_CASE_METHOD(SpiderFixture, "Oversampling benchmark", "[.][benchmark]") {
+    const int frames = 256;
+    const int channels = GENERATE(1, 16);
+
+    for (int op = 0; op < 6; ++op) {
+        spider->getParam(Spider::LEVEL_PARAMS + op).setValue(0.8f);
+        spider->getParam(Spider::WAVE_PARAMS + op).setValue(0.2f * op);
+    }
+    spider->carriers[0] = true;
+    spider->algorithmGraph.addEdge(1, 0);
+    spider->algorithmGraph.addEdge(2, 1);
+    spider->algorithmGraph.addEdge(3, 0);
+    spider->updateSchedule();
+    spider->receiveSchedule();
+    spider->engine.channels = channels;
+
+    std::vector<float> pitch(frames * MAX_CHANNEL_COUNT, 0.f);
+    std::vector<float> output(frames * MAX_CHANNEL_COUNT);
+
+    Module::ProcessArgs processArgs;
+    processArgs.sampleRate = sampleRate;
+    processArgs.sampleTime = 1.f / sampleRate;
+
+    for (int factor : {1, 2, 4, 8}) {
+        spider->engine.oversampling = factor;
+
+        BENCHMARK(std::to_string(channels) + " channels, " + std::to_string(factor) + "x, 256 frames") {
+            spider->renderBlock(processArgs, frames, pitch.data(), output.data());
+            return output[0];
+        };
+    }
+}
+
 TEST_CASE_METHOD(SpiderFixture, "Module state is correctly preserved", "[JSON]") {
     spider->model = modelPostHumanSpider;
     spider->algorithmGraph.addEdge(1, 0);
     spider->algorithmGraph.addEdge(2, 1);
-    spider->topologicalOrder = spider->algorithmGraph.topologicalSort();
+    spider->updateSchedule();
     spider->carriers[0] = true;
+    spider->engine.controlDivision = 64;
+    spider->engine.audioRateCv = true;
+    spider->engine.oversampling = 4;
+    spider->engine.bandLimited = true;
+    spider->setModulationDepth(1, 0, 0.5f);
+    spider->setModulationDepth(3, 4, 1.25f);
 
     json_t* state = spider->toJson();
 
@@ -705,6 +1510,39 @@ TEST_CASE_METHOD(SpiderFixture, "Module state is correctly preserved", "[JSON]")
     REQUIRE(newSpider->algorithmGraph == spider->algorithmGraph);
     REQUIRE(newSpider->carriers == spider->carriers);
     REQUIRE(newSpider->topologicalOrder == spider->topologicalOrder);
+    REQUIRE(newSpider->engine.controlDivision == spider->engine.controlDivision);
+    REQUIRE(newSpider->engine.audioRateCv == spider->engine.audioRateCv);
+    REQUIRE(newSpider->engine.oversampling == spider->engine.oversampling);
+    REQUIRE(newSpider->engine.bandLimited == spider->engine.bandLimited);
+    REQUIRE(newSpider->modulationDepths == spider->modulationDepths);
+    REQUIRE(newSpider->pendingSchedule.modulationDepths[0][0] == 0.5f);
+}
+
+TEST_CASE_METHOD(SpiderFixture, "Library algorithm is preserved", "[JSON]") {
+    spider->model = modelPostHumanSpider;
+    spider->loadAlgorithm(17);
+
+    json_t* state = spider->toJson();
+
+    auto newSpider = std::make_unique<Spider>();
+    newSpider->model = modelPostHumanSpider;
+    newSpider->fromJson(state);
+
+    REQUIRE(newSpider->libraryAlgorithm == 17);
+    REQUIRE(newSpider->algorithmGraph == spider->algorithmGraph);
+    REQUIRE(newSpider->carriers == spider->carriers);
+
+    // A patch can name a library algorithm without spelling out the graph
+    json_t* dataJ = json_object_get(state, "data");
+    json_object_del(dataJ, "algorithm");
+    json_object_del(dataJ, "carriers");
+
+    auto namedSpider = std::make_unique<Spider>();
+    namedSpider->model = modelPostHumanSpider;
+    namedSpider->fromJson(state);
+
+    REQUIRE(namedSpider->algorithmGraph == spider->algorithmGraph);
+    REQUIRE(namedSpider->carriers == spider->carriers);
 }
 
 } // namespace ph
@@ -0,0 +1,70 @@
+#include <catch2/catch_all.hpp>
+#include <thread>
+#include "../src/SpscRingBuffer.hpp"
+
+using namespace Catch;
+using namespace Catch::Matchers;
+using namespace Catch::Generators;
+
+namespace ph {
+
+TEST_CASE("Ring buffer returns values in the order they were pushed", "[SpscRingBuffer]") {
+    SpscRingBuffer<int, 4> buffer;
+    REQUIRE(buffer.empty());
+
+    // Enough rounds for the indices to wrap several times
+    for (int round = 0; round < 10; ++round) {
+        for (int i = 0; i < 3; ++i) {
+            buffer.push(round * 3 + i);
+        }
+        REQUIRE(buffer.size() == 3);
+
+        for (int i = 0; i < 3; ++i) {
+            REQUIRE(buffer.shift() == round * 3 + i);
+        }
+        REQUIRE(buffer.empty());
+    }
+}
+
+TEST_CASE("Ring buffer is full at its size", "[SpscRingBuffer]") {
+    SpscRingBuffer<int, 4> buffer;
+    for (int i = 0; i < 4; ++i) {
+        REQUIRE_FALSE(buffer.full());
+        buffer.push(i);
+    }
+    REQUIRE(buffer.full());
+    REQUIRE_FALSE(buffer.empty());
+
+    buffer.shift();
+    REQUIRE_FALSE(buffer.full());
+
+    buffer.clear();
+    REQUIRE(buffer.empty());
+    REQUIRE(buffer.size() == 0);
+}
+
+TEST_CASE("Ring buffer hands every value from one thread to another", "[SpscRingBuffer]") {
+    SpscRingBuffer<int, 64> buffer;
+    const int count = 100000;
+
+    std::thread producer([&] {
+        for (int i = 0; i < count;) {
+            if (!buffer.full()) {
+                buffer.push(i++);
+            }
+        }
+    });
+
+    bool ordered = true;
+    for (int expected = 0; expected < count;) {
+        if (!buffer.empty()) {
+            ordered &= buffer.shift() == expected++;
+        }
+    }
+    producer.join();
+
+    REQUIRE(ordered);
+    REQUIRE(buffer.empty());
+}
+
+} // namespace ph